@@ -4,10 +4,21 @@
 #define _CPPAUPARSER_ALL_H_
 
 #include "base.h"
+#include "batch.h"
+#include "budget.h"
+#include "cache.h"
+#include "extract.h"
 #include "grammar.h"
+#include "hash.h"
+#include "incremental.h"
+#include "lazy.h"
 #include "lexer.h"
+#include "parallel.h"
 #include "parser.h"
+#include "pipeline.h"
+#include "static.h"
 #include "strs.h"
+#include "tape.h"
 #include "tree.h"
 #include "utility.h"
 
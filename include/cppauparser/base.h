@@ -35,6 +35,15 @@
 # define NULL_PTR 0
 #endif
 
+// constexpr is needed by tables generated with "auparser-tool tables"
+#if (defined(_MSC_VER) && _MSC_VER < 1900) || \
+    (defined(__GNUC__) && !defined(__clang__) && \
+     (__GNUC__ * 100 + __GNUC_MINOR__) < 406)
+# define CPPAUPARSER_HAS_CONSTEXPR 0
+#else
+# define CPPAUPARSER_HAS_CONSTEXPR 1
+#endif
+
 #define CPPAUPARSER_UNCOPYABLE(T) \
   private: \
     T(const T&); \
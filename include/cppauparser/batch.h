@@ -0,0 +1,139 @@
+// Copyright 2012 Esun Kim
+
+#ifndef _CPPAUPARSER_BATCH_H_
+#define _CPPAUPARSER_BATCH_H_
+
+#include "base.h"
+#include "grammar.h"
+#include "strs.h"
+#include "tree.h"
+#include "utility.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cppauparser {
+
+// BatchParser parses many texts on a pool of threads sharing one grammar.
+// Each worker keeps its own ParseSession so that a worker allocates
+// nothing for small texts in a steady state.
+//
+// Texts of a batch are divided among workers in ranges. A worker takes
+// a chunk of texts from a front of its range at once, and a worker
+// without texts steals a back half of a longest range of others.
+// An ordered batch hands out texts in their order instead (one at once
+// unless SetChunkSize is set). A result which can't be delivered yet is
+// parked with its session and a worker goes on with a spare session,
+// and a worker which parses a next text delivers parked results after it.
+// Texts should be kept alive until their batch is done.
+class CppAuParserDecl BatchParser {
+ public:
+  // 0 threads for hardware concurrency
+  explicit BatchParser(const Grammar& grammar, size_t thread_count = 0);
+  ~BatchParser();
+
+  // builds simplified trees. (see ParseStringToSTree)
+  void SetSimplified(bool simplified);
+  // texts taken at once. 0 chooses by a size of a batch.
+  void SetChunkSize(size_t size);
+  // callbacks are called in an order of texts.
+  void SetOrdered(bool ordered);
+  // limits of each parse. set them while no batch is running.
+  void SetLimits(const ParseLimits& limits);
+  size_t GetThreadCount() const;
+
+  // calls callback(index, result, session) on a worker for each text and
+  // returns when all are done. a result is NULL on failure
+  // (see session.GetErrorInfo. kNone when a text couldn't be loaded)
+  // and valid only in a call.
+  template<typename C>
+  void ParseBuffers(const utf8_substring* texts, size_t count,
+                    const C& callback) {
+    Run(count, BufferParse(texts), [&callback](ParseSession& session,
+                                               size_t i) {
+      callback(i, session.GetResult(), session);
+    }, true);
+  }
+
+  template<typename C>
+  void ParseFiles(const PATHCHAR* const* file_paths, size_t count,
+                  const C& callback) {
+    Run(count, FileParse(file_paths), [&callback](ParseSession& session,
+                                                  size_t i) {
+      callback(i, session.GetResult(), session);
+    }, true);
+  }
+
+  // returns at once with futures of results which own their trees
+  // like ParseBufferToTree.
+  std::vector<std::future<ParseToTreeResult> > ParseBuffersAsync(
+      const utf8_substring* texts, size_t count);
+  std::vector<std::future<ParseToTreeResult> > ParseFilesAsync(
+      const PATHCHAR* const* file_paths, size_t count);
+
+ private:
+  // a batch parses a text with a session and then delivers its result
+  typedef std::function<void(ParseSession&, size_t)> Job;
+
+  struct Range {
+    std::mutex mutex;
+    size_t begin;
+    size_t end;
+  };
+
+  struct Batch {
+    Job parse;
+    Job deliver;
+    size_t chunk;
+    bool ordered;
+    std::unique_ptr<Range[]> ranges;
+    std::atomic<size_t> left;
+    std::mutex mutex;
+    std::condition_variable cond;
+    // when ordered, a next text to be taken, a next one to be delivered
+    // and sessions of parsed texts waiting for their turn
+    std::atomic<size_t> taken;
+    size_t next;
+    std::vector<std::unique_ptr<ParseSession> > parked;
+  };
+
+  Job BufferParse(const utf8_substring* texts) const;
+  Job FileParse(const PATHCHAR* const* file_paths) const;
+  std::vector<std::future<ParseToTreeResult> > RunAsync(size_t count,
+                                                        const Job& parse);
+  void Run(size_t count, const Job& parse, const Job& deliver, bool wait);
+  void RunWorker(size_t index);
+  bool Take(Batch* batch, size_t index, size_t* begin, size_t* end);
+  void DeliverOrdered(Batch* batch, size_t index, size_t i);
+  std::unique_ptr<ParseSession> TakeSpareSession();
+
+ private:
+  const Grammar& grammar_;
+  bool simplified_;
+  size_t chunk_size_;
+  bool ordered_;
+
+  ParseLimits limits_;
+
+  std::vector<std::thread> threads_;
+  std::vector<std::unique_ptr<ParseSession> > sessions_;
+  // sessions given back by parked results, up to a thread count.
+  // guarded by mutex_.
+  std::vector<std::unique_ptr<ParseSession> > spare_sessions_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<std::shared_ptr<Batch> > batches_;
+  bool stop_;
+
+  CPPAUPARSER_UNCOPYABLE(BatchParser);
+};
+
+}  // namespace cppauparser
+
+#endif  // _CPPAUPARSER_BATCH_H_
@@ -0,0 +1,97 @@
+// Copyright 2012 Esun Kim
+
+#ifndef _CPPAUPARSER_BUDGET_H_
+#define _CPPAUPARSER_BUDGET_H_
+
+#include "base.h"
+#include "parser.h"
+#include <atomic>
+#include <chrono>
+
+namespace cppauparser {
+
+// budgets of ParseFor and ParseAll. they are kept out of parser.h since
+// they need std::atomic and std::chrono.
+
+// a flag to stop a running parse from another thread.
+class CppAuParserDecl CancellationToken {
+ public:
+  CancellationToken();
+
+  void Cancel();
+  void Reset();
+  bool IsCancelled() const;
+
+ private:
+  std::atomic<bool> cancelled_;
+
+  CPPAUPARSER_UNCOPYABLE(CancellationToken);
+};
+
+// limits of a single ParseFor or ParseAll call.
+// when steps or time run out, parsing stops with kSuspended and can be
+// resumed by a next call. a deadline and a cancellation are polled every
+// kPollInterval steps to keep reading a clock off a hot loop.
+struct CppAuParserDecl ParseBudget {
+  typedef std::chrono::steady_clock Clock;
+  static const size_t kPollInterval = 256;
+
+  size_t max_steps;
+  Clock::time_point deadline;
+  const CancellationToken* cancellation;
+
+ public:
+  ParseBudget();
+  explicit ParseBudget(size_t max_steps);
+  explicit ParseBudget(Clock::time_point deadline);
+  ParseBudget(size_t max_steps, Clock::time_point deadline,
+              const CancellationToken* cancellation);
+};
+
+template<typename T>
+ParseResultType::T Parser::ParseAll(const T& handler,
+                                    const ParseBudget& budget) {
+  for (size_t steps = 0; ; ++steps) {
+    ParseResultType::T ret =
+        (steps % ParseBudget::kPollInterval != 0 && steps != budget.max_steps)
+        ? ParseStep() : ParseStepWithin(budget, steps);
+    if (CPPAUPARSER_HANDLER_WANTS(T, ret)) {
+      handler(ret, *this);
+      if (abort_ != ParseErrorType::kNone) {
+        return Fail(abort_);
+      }
+    }
+    if (ret == ParseResultType::kAccept ||
+        ret == ParseResultType::kError ||
+        ret == ParseResultType::kNeedMoreInput ||
+        ret == ParseResultType::kSuspended) {
+      return ret;
+    }
+  }
+}
+
+template<typename T>
+ParseResultType::T Parser::ParseAll(T& handler,
+                                    const ParseBudget& budget) {
+  for (size_t steps = 0; ; ++steps) {
+    ParseResultType::T ret =
+        (steps % ParseBudget::kPollInterval != 0 && steps != budget.max_steps)
+        ? ParseStep() : ParseStepWithin(budget, steps);
+    if (CPPAUPARSER_HANDLER_WANTS(T, ret)) {
+      handler(ret, *this);
+      if (abort_ != ParseErrorType::kNone) {
+        return Fail(abort_);
+      }
+    }
+    if (ret == ParseResultType::kAccept ||
+        ret == ParseResultType::kError ||
+        ret == ParseResultType::kNeedMoreInput ||
+        ret == ParseResultType::kSuspended) {
+      return ret;
+    }
+  }
+}
+
+}  // namespace cppauparser
+
+#endif  // _CPPAUPARSER_BUDGET_H_
@@ -0,0 +1,116 @@
+// Copyright 2012 Esun Kim
+
+#ifndef _CPPAUPARSER_CACHE_H_
+#define _CPPAUPARSER_CACHE_H_
+
+#include "base.h"
+#include "grammar.h"
+#include "hash.h"
+#include "strs.h"
+#include "utility.h"
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace cppauparser {
+
+// ParseCache keeps results of the ParseToTree family by contents of texts.
+// a text seen before with the same grammar gets a kept result back
+// without lexing or parsing.
+//
+// A key is a 128 bit hash of a text, its size, a grammar and its
+// fingerprint and a kind of a tree. A hit also compares a kept text with
+// a given one, so a collision of hashes is parsed as a miss. Keys are
+// split into shards which have their own lock and LRU list with an even
+// share of bytes, so lookups from many threads rarely wait for each other.
+// A result of a hit shares a text and a tree with a kept one and they
+// should not be changed. Failed parses are not kept. Simplified trees
+// depend on sr_* options of productions, which should be set before
+// a cache is used. (or Clear it after) Kept trees refer to symbols and
+// productions of a grammar, so a grammar should live longer than a cache
+// or be cleared from it first.
+class CppAuParserDecl ParseCache {
+ public:
+  // bytes of kept texts and trees in total
+  explicit ParseCache(size_t max_bytes, size_t shard_count = 16);
+  ~ParseCache();
+
+  ParseToTreeResult ParseFileToTree(const Grammar& grammar,
+                                    const PATHCHAR* file_path);
+  ParseToTreeResult ParseStringToTree(const Grammar& grammar, const char* s);
+  ParseToTreeResult ParseBufferToTree(const Grammar& grammar,
+                                      const byte* buf, size_t size);
+  ParseToTreeResult ParseFileToSTree(const Grammar& grammar,
+                                     const PATHCHAR* file_path);
+  ParseToTreeResult ParseStringToSTree(const Grammar& grammar, const char* s);
+  ParseToTreeResult ParseBufferToSTree(const Grammar& grammar,
+                                       const byte* buf, size_t size);
+
+  void Clear();
+
+  size_t GetUsedBytes() const;
+  size_t GetEntryCount() const;
+  size_t GetHitCount() const;
+  size_t GetMissCount() const;
+
+ private:
+  struct Key {
+    Hash128 text;
+    const Grammar* grammar;
+    Hash128 fingerprint;
+    size_t size;
+    bool simplified;
+
+   public:
+    bool operator==(const Key& k) const {
+      return text == k.text && grammar == k.grammar &&
+             fingerprint == k.fingerprint && size == k.size &&
+             simplified == k.simplified;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& k) const {
+      return static_cast<size_t>(k.text.low ^ k.fingerprint.low);
+    }
+  };
+
+  struct Entry {
+    Key key;
+    ParseToTreeResult result;
+    // owned by a lexer buffer of a result
+    const byte* text;
+    size_t bytes;
+  };
+
+  typedef std::list<Entry> EntryList;
+
+  struct Shard {
+    std::mutex mutex;
+    // most recently used first
+    EntryList entries;
+    std::unordered_map<Key, EntryList::iterator, KeyHash> index;
+    size_t used_bytes;
+  };
+
+  // owned is a copy of buf made by malloc or NULL. a cache takes it.
+  ParseToTreeResult Parse(const Grammar& grammar, const byte* buf,
+                          size_t size, byte* owned, bool simplified);
+  ParseToTreeResult ParseFile(const Grammar& grammar,
+                              const PATHCHAR* file_path, bool simplified);
+
+ private:
+  size_t shard_bytes_;
+  size_t shard_count_;
+  std::unique_ptr<Shard[]> shards_;
+  std::atomic<size_t> hit_count_;
+  std::atomic<size_t> miss_count_;
+
+  CPPAUPARSER_UNCOPYABLE(ParseCache);
+};
+
+}  // namespace cppauparser
+
+#endif  // _CPPAUPARSER_CACHE_H_
@@ -0,0 +1,85 @@
+// Copyright 2012 Esun Kim
+
+#ifndef _CPPAUPARSER_EXTRACT_H_
+#define _CPPAUPARSER_EXTRACT_H_
+
+#include "base.h"
+#include "grammar.h"
+#include "parser.h"
+#include "strs.h"
+#include <vector>
+
+namespace cppauparser {
+
+// texts picked by a column. i-th text is [offsets[i], offsets[i] + sizes[i])
+// of a loaded buffer.
+struct CppAuParserDecl ExtractColumn {
+  std::vector<size_t> offsets;
+  std::vector<size_t> sizes;
+};
+
+// ColumnExtractor is a ParseAll handler which appends texts of chosen
+// symbols to columns while parsing. No tree is built.
+//
+// A symbol column takes every token of a terminal. A production column
+// takes a text of a handle whenever a production is reduced, and can be
+// narrowed to reductions where a text of another handle equals a key.
+// e.g. values of a member "name" in JSON:
+//   AddColumn("<Member> ::= String : <Value>", 2, 0, "\"name\"")
+class CppAuParserDecl ColumnExtractor {
+ public:
+  explicit ColumnExtractor(const Grammar& grammar);
+
+  // return a column index or -1 when an id is not found
+  int AddColumn(const char* symbol_id);
+  int AddColumn(const char* production_id, int handle);
+  int AddColumn(const char* production_id, int handle,
+                int key_handle, const char* key);
+
+  // clears columns for a new parse of a buffer. offsets are from base.
+  void Reset(const byte* base);
+
+  void operator()(ParseResultType::T ret, const Parser& parser);
+
+  const ExtractColumn& GetColumn(int column) const;
+  utf8_substring GetText(int column, size_t i) const;
+
+ private:
+  struct Column {
+    int handle;
+    int key_handle;
+    utf8_string key;
+    int next;
+    ExtractColumn data;
+  };
+
+  struct Span {
+    size_t offset;
+    size_t end;
+  };
+
+  int AddColumn(std::vector<int>* heads, int index, int handle,
+                int key_handle, const char* key);
+  size_t GetOffset(const Token& token) const;
+
+ private:
+  const Grammar& grammar_;
+  const byte* base_;
+  std::vector<Column> columns_;
+  // first column of each symbol and production. -1 for none.
+  std::vector<int> symbol_columns_;
+  std::vector<int> production_columns_;
+  // spans of items on a parser stack. kept only for production columns.
+  std::vector<Span> spans_;
+  bool track_spans_;
+};
+
+template<>
+struct ParseHandlerTraits<ColumnExtractor> {
+  static const int kEvents =
+      ParseEventMask::kShift | ParseEventMask::kReduce;
+};
+
+}  // namespace cppauparser
+
+#endif  // _CPPAUPARSER_EXTRACT_H_
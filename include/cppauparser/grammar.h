@@ -4,10 +4,12 @@
 #define _CPPAUPARSER_GRAMMAR_H_
 
 #include "base.h"
+#include "hash.h"
 #include "strs.h"
 #include <stdint.h>
 #include <vector>
 #include <map>
+#include <memory>
 #include <utility>
 
 namespace cppauparser {
@@ -145,27 +147,118 @@ class CppAuParserDecl LALRState {
   std::vector<LALRAction*> jmp_table;
 };
 
+// sizes of tables before and after Grammar minimizes them
+struct CppAuParserDecl MinimizeStats {
+  struct Counts {
+    size_t dfa_states;
+    size_t dfa_edges;
+    size_t charsets;
+    size_t lalr_states;
+  };
+  Counts before;
+  Counts after;
+};
+
+// visits of states which a grammar with profiling counts
+class CppAuParserDecl GrammarProfile {
+ public:
+  bool LoadFile(const PATHCHAR* file_path);
+  bool SaveFile(const PATHCHAR* file_path) const;
+
+ public:
+  // a fingerprint of a grammar counting visits
+  Hash128 fingerprint;
+  std::vector<uint64_t> dfa_visits;
+  std::vector<uint64_t> lalr_visits;
+};
+
 class CppAuParserDecl Grammar {
  public:
   Grammar();
+  ~Grammar();
 
   bool LoadFile(const PATHCHAR* file_path);
   bool LoadBuffer(const char* buf, size_t len);
 
+  // with a lazy lookup, jmp_table and jmp_ranges of a state are built when
+  // a lexer or a parser enters it first instead of for every state on a
+  // load. it takes effect from a next load and is safe with many threads.
+  void SetLazyLookup(bool lazy);
+
+  // with a minimize, a load merges equivalent DFA states and removes
+  // states no input reaches and charsets no edge uses. tokens are matched
+  // as before but indices of states change and so does a fingerprint.
+  // it takes effect from a next load.
+  void SetMinimize(bool minimize);
+  const MinimizeStats& GetMinimizeStats() const;
+
+  // with profiling, lexers and parsers count visits of states. it takes
+  // effect from a next load and GetProfile returns counts so far. they
+  // count on a path of their own, so a grammar without it pays nothing.
+  void SetProfiling(bool profiling);
+  bool GetProfile(GrammarProfile* profile) const;
+
+  // a load renumbers states by visits of a profile, hottest first, so that
+  // hot states are near each other. a profile should be made with a grammar
+  // loaded with the same file and options and others are ignored.
+  // it takes effect from a next load.
+  void SetLayoutProfile(const GrammarProfile& profile);
+  bool IsLayoutApplied() const;
+
  private:
   void ProcessAfterLoad();
   void LinkReference();
   void BuildDFALookup();
   void BuildLALRLookup();
+  void BuildDFALookup(DFAState* state) const;
+  void BuildLALRLookup(LALRState* state) const;
+  void EnterDFAState(int index) const;
+  void EnterLALRState(int index) const;
   void SetSingleLexemeSymbol();
   void SetSimplicationRule();
+  void Minimize(bool minimize);
+  bool MinimizeDFA();
+  bool PruneCharsets();
+  bool PruneLALR();
+  bool ApplyLayout();
+  void PrepareProfiling();
 
  public:
+  // a state with its lookup built. a lexer and a parser get states here.
+  const DFAState* GetDFAState(int index) const {
+    if (dfa_direct_ == false) {
+      EnterDFAState(index);
+    }
+    return &dfa_states[index];
+  }
+
+  const LALRState* GetLALRState(int index) const {
+    if (lalr_direct_ == false) {
+      EnterLALRState(index);
+    }
+    return &lalr_states[index];
+  }
+
+  // whether every state has its lookup built and no visit is counted.
+  // a lexer and a parser check it once for a token and then index states
+  // directly instead of through GetDFAState and GetLALRState.
+  bool IsDFADirect() const {
+    return dfa_direct_;
+  }
+
+  bool IsLALRDirect() const {
+    return lalr_direct_;
+  }
+
   Symbol* GetSymbol(const utf8_string& id) const;
   Symbol* GetSymbol(const char* id) const;
   Production* GetProduction(const utf8_string& id) const;
   Production* GetProduction(const char* id) const;
 
+  // a hash of loaded tables to tell grammars apart. options of productions
+  // changed after a load (sr_*) are not in it.
+  const Hash128& GetFingerprint() const;
+
  public:
   std::vector<Property> properties;
   std::vector<CharacterSet> charsets;
@@ -180,8 +273,21 @@ class CppAuParserDecl Grammar {
   const Symbol* symbol_Error;
 
  private:
+  Hash128 fingerprint_;
   std::map<utf8_string, const Symbol*> symbol_pname_lookup_;
   std::map<utf8_string, const Production*> production_pname_lookup_;
+  bool lazy_lookup_;
+  bool minimize_;
+  MinimizeStats minimize_stats_;
+  bool profiling_;
+  // flags of lazy lookups and visits of states. they are kept in grammar.cpp
+  // so that this header doesn't need std::atomic and std::mutex.
+  struct StateCounters;
+  std::unique_ptr<StateCounters> counters_;
+  bool dfa_direct_;
+  bool lalr_direct_;
+  GrammarProfile layout_profile_;
+  bool layout_applied_;
 
   CPPAUPARSER_UNCOPYABLE(Grammar);
 };
@@ -0,0 +1,36 @@
+// Copyright 2012 Esun Kim
+
+#ifndef _CPPAUPARSER_HASH_H_
+#define _CPPAUPARSER_HASH_H_
+
+#include "base.h"
+#include <stdint.h>
+#include <stddef.h>
+
+namespace cppauparser {
+
+// a 128 bit hash of bytes. (MurmurHash3 x64 128)
+// it's fast and spreads well but isn't for hostile collisions.
+struct CppAuParserDecl Hash128 {
+  uint64_t low;
+  uint64_t high;
+
+ public:
+  Hash128();
+  Hash128(uint64_t low, uint64_t high);
+
+  bool operator==(const Hash128& h) const {
+    return low == h.low && high == h.high;
+  }
+
+  bool operator!=(const Hash128& h) const {
+    return !(*this == h);
+  }
+};
+
+CppAuParserDecl Hash128 HashBytes(const void* buf, size_t size,
+                                  uint64_t seed = 0);
+
+}  // namespace cppauparser
+
+#endif  // _CPPAUPARSER_HASH_H_
@@ -0,0 +1,109 @@
+// Copyright 2012 Esun Kim
+
+#ifndef _CPPAUPARSER_INCREMENTAL_H_
+#define _CPPAUPARSER_INCREMENTAL_H_
+
+#include "base.h"
+#include "grammar.h"
+#include "parser.h"
+#include "tree.h"
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <utility>
+
+namespace cppauparser {
+
+// an edit in byte offsets.
+// [start, old_end) of an old text is replaced with [start, new_end) of a new one.
+struct CppAuParserDecl TextEdit {
+  size_t start;
+  size_t old_end;
+  size_t new_end;
+
+ public:
+  TextEdit();
+  TextEdit(size_t start, size_t old_end, size_t new_end);
+};
+
+// IncrementalParser keeps a parse tree of the last text and reparses an edited
+// text by reusing subtrees which are not touched by an edit.
+// A subtree is reused when parser reaches its first token in the same LALR
+// state as before and no byte read to build it (including a lookahead token
+// that reduced it) is edited. Only a damaged region is lexed and parsed again.
+//
+// A tree has the same shape as one built by TreeBuilder.
+// Like Parser::LoadBuffer, a text is not copied and should be kept alive
+// until a next Parse or Reparse.
+class CppAuParserDecl IncrementalParser {
+ public:
+  explicit IncrementalParser(const Grammar& grammar);
+  ~IncrementalParser();
+
+  bool Parse(const byte* buf, size_t size);
+  bool Reparse(const byte* buf, size_t size, const TextEdit& edit);
+  void Clear();
+
+  TreeNode* GetResult() const;
+  const ParseErrorInfo& GetErrorInfo() const;
+  size_t GetReusedNodeCount() const;
+
+ private:
+  // a non-terminal node in postfix order. a subtree of infos[i] is
+  // infos[i-count+1 .. i] and begin is an offset of its first token.
+  struct NodeInfo {
+    TreeNode* node;
+    size_t begin;
+    size_t dep_end;
+    int state;
+    size_t count;
+  };
+
+  struct Item {
+    TreeNode* node;
+    size_t begin;
+    size_t count;
+  };
+
+  struct Splice {
+    TreeNode* node;
+    ptrdiff_t shift;
+    std::pair<int, int> old_position;
+    std::pair<int, int> new_position;
+  };
+
+  bool Run(const byte* buf, size_t size, const TextEdit* edit);
+  bool Reuse(const byte* buf, size_t size, const TextEdit& edit);
+  size_t GetScanDependency(size_t size) const;
+  void Commit(const byte* buf, std::shared_ptr<TreeNodeAllocator> allocator);
+  size_t RebaseSubtree(const byte* buf, const Splice& splice);
+  void BuildOrder();
+  void Compact();
+
+ private:
+  const Grammar& grammar_;
+  Parser parser_;
+
+  TreeNode* result_;
+  TreeNode* root_;
+  uintptr_t base_;
+  std::vector<NodeInfo> infos_;
+  std::vector<size_t> order_;
+  std::vector<std::shared_ptr<TreeNodeAllocator>> allocators_;
+  TextEdit pending_edit_;
+  bool pending_;
+  size_t reused_count_;
+
+  // scratch for a running parse
+  std::vector<Item> items_;
+  std::vector<NodeInfo> new_infos_;
+  std::vector<Splice> splices_;
+  size_t cursor_;
+  size_t dep_max_;
+
+  CPPAUPARSER_UNCOPYABLE(IncrementalParser);
+};
+
+}  // namespace cppauparser
+
+#endif  // _CPPAUPARSER_INCREMENTAL_H_
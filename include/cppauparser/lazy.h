@@ -0,0 +1,91 @@
+// Copyright 2012 Esun Kim
+
+#ifndef _CPPAUPARSER_LAZY_H_
+#define _CPPAUPARSER_LAZY_H_
+
+#include "base.h"
+#include "grammar.h"
+#include "lexer.h"
+#include "parser.h"
+#include "tree.h"
+#include <vector>
+#include <utility>
+
+namespace cppauparser {
+
+// a subtree which is not parsed yet. it is a non-terminal node whose
+// child_count is -1 so a code that doesn't know it sees no children.
+// production is the first one of a lazy symbol.
+struct CppAuParserDecl TreeNodeLazy : public TreeNodeNonTerminal {
+  const LALRState* state;
+  size_t offset;
+  size_t size;
+  std::pair<int, int> position;
+  TreeNode* materialized;
+
+ public:
+  TreeNodeLazy(const Production* production, const LALRState* state,
+               size_t offset, size_t size, std::pair<int, int> position);
+};
+
+// LazyParser builds a tree like TreeBuilder but skips texts of lazy
+// symbols. When a parser is about to shift an open token of a lazy symbol,
+// tokens are scanned without parsing up to a matching close token and
+// a TreeNodeLazy is shifted in place of a subtree. Resolve parses it
+// (lazy symbols in it are skipped again) when a caller visits it.
+//
+// Every text of a lazy symbol should start with open and end with close,
+// and open should start nothing else where a lazy symbol can come.
+// An error in a skipped text is reported by Resolve. When delimiters
+// don't match, an error can be reported at another token than Parser does.
+// A text is not copied and should be kept alive while a tree is used.
+class CppAuParserDecl LazyParser {
+ public:
+  explicit LazyParser(const Grammar& grammar);
+  ~LazyParser();
+
+  // ids are as Symbol::GetID. e.g. ("<Object>", "{", "}")
+  bool SetLazy(const char* symbol_id, const char* open_id,
+               const char* close_id);
+
+  bool Parse(const byte* buf, size_t size);
+  TreeNode* GetResult() const;
+
+  // a node itself or a subtree parsed from a lazy node.
+  // NULL when parsing a lazy node fails. (see GetErrorInfo)
+  TreeNode* Resolve(TreeNode* node);
+  static bool IsLazy(const TreeNode* node);
+
+  const ParseErrorInfo& GetErrorInfo() const;
+  size_t GetSkippedCount() const;
+
+ private:
+  struct Lazy {
+    const Symbol* symbol;
+    const Production* production;
+    int open;
+    int close;
+  };
+
+  bool Run(TreeNodeLazy* from, TreeNode** result);
+  bool Skip(const Lazy& lazy, const Token& token);
+
+ private:
+  const Grammar& grammar_;
+  Parser parser_;
+  Lexer scanner_;
+  TreeBuilder builder_;
+  std::vector<Lazy> lazies_;
+  std::vector<int> lazy_by_open_;
+
+  const byte* buf_;
+  size_t size_;
+  TreeNode* result_;
+  size_t skipped_count_;
+
+  CPPAUPARSER_UNCOPYABLE(LazyParser);
+};
+
+}  // namespace cppauparser
+
+#endif  // _CPPAUPARSER_LAZY_H_
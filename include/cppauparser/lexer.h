@@ -34,6 +34,7 @@ class CppAuParserDecl LexerBuffer {
   byte* GetBuffer();
   size_t GetBufferSize();
   void SetBuffer(byte* buf, size_t size, bool sharable);
+  void AddChunk(byte* buf);
 
   void Clear();
   void Swap(LexerBuffer& b);
@@ -42,10 +43,28 @@ class CppAuParserDecl LexerBuffer {
   byte* buf_;
   size_t buf_size_;
   bool buf_sharable_;
+  std::vector<byte*> chunks_;
 
   CPPAUPARSER_UNCOPYABLE(LexerBuffer);
 };
 
+// a saved position of a lexer including open groups.
+// offsets are the same ones as Lexer::GetOffset.
+struct CppAuParserDecl LexerState {
+  struct Group {
+    const SymbolGroup* symbol_group;
+    size_t offset;
+    size_t size;
+  };
+
+  size_t offset;
+  std::pair<int, int> position;
+  std::vector<Group> groups;
+
+ public:
+  LexerState();
+};
+
 class CppAuParserDecl Lexer {
  public:
   explicit Lexer(const Grammar& grammar);
@@ -57,9 +76,23 @@ class CppAuParserDecl Lexer {
   void Unload();
   void ResetCursor();
 
+  // stream mode. LoadStream starts an empty text and Feed appends bytes to it.
+  // while a stream is open, a token (or a group) reaching the end of fed bytes
+  // is not decided and ReadToken returns a token of which symbol is NULL.
+  // Finish closes a stream and the rest is lexed as usual.
+  bool LoadStream();
+  void Feed(const byte* buf, size_t size);
+  void Finish();
+  bool IsStreamOpen() const;
+  // bytes fed but not read as a token yet. (from a start of an open group)
+  size_t GetPendingSize() const;
+
   std::shared_ptr<LexerBuffer> ReleaseBuffer();
 
  private:
+  int MatchToken(byte** hit_end, byte** end);
+  template<bool kDirect>
+  int MatchTokenIn(byte** hit_end, byte** end);
   void PeekToken(Token* token);
   void AdvancePeekBuffer();
   void AdvanceBuffer(size_t n);
@@ -67,10 +100,31 @@ class CppAuParserDecl Lexer {
  public:
   void ReadToken(Token* token);
 
+  // fast path of ReadToken for a validation. only a symbol is returned and
+  // noise is skipped. a position is not tracked outside of groups.
+  // offset gets where scanning of a symbol started. (including noise)
+  const Symbol* ReadSymbol(size_t* offset);
+
   int GetLine() const;
   int GetColumn() const;
   std::pair<int, int> GetPosition() const;
 
+  // cursor control for drivers that skip over text they parsed before.
+  // offsets are relative to the start of the loaded buffer (or stream) and
+  // a scan offset is the end of the furthest byte examined by the DFA.
+  size_t GetOffset() const;
+  size_t GetScanOffset() const;
+  void Seek(size_t offset, std::pair<int, int> position);
+  // a loaded text. a stream has only bytes of its current chunk.
+  utf8_substring GetText() const;
+
+  // a stream can be restored only to a state in its current chunk.
+  void SaveState(LexerState* state) const;
+  bool RestoreState(const LexerState& state);
+
+  static std::pair<int, int> AdvancePosition(std::pair<int, int> position,
+                                             const byte* buf, size_t size);
+
  private:
   const Grammar& grammar_;
 
@@ -79,6 +133,10 @@ class CppAuParserDecl Lexer {
   byte* buf_cur_;
   byte* buf_end_;
   byte* buf_peek_;
+  byte* buf_scan_;
+  byte* buf_cap_;
+  size_t buf_base_;
+  bool stream_open_;
 
   int line_;
   int column_;
@@ -0,0 +1,109 @@
+// Copyright 2012 Esun Kim
+
+#ifndef _CPPAUPARSER_PARALLEL_H_
+#define _CPPAUPARSER_PARALLEL_H_
+
+#include "base.h"
+#include "grammar.h"
+#include "lexer.h"
+#include "parser.h"
+#include "tree.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <utility>
+
+namespace cppauparser {
+
+// ParallelParser builds a tree like TreeBuilder but parses a long list
+// on several threads. When a parser is about to parse a list symbol,
+// tokens are scanned up to an end of the list while counting nesting
+// and the list is cut at separators out of nesting into chunks.
+// Each chunk is parsed by its own Parser starting from the state where
+// the list begins, and trees of chunks are joined into one left recursive
+// tree. A tree is the same as one of Parser and TreeBuilder whether a list
+// is split or not.
+//
+// A list symbol should have a left recursive production whose separator
+// follows a recursive handle (<L> ::= <L> ',' <E>) or ends it
+// (<L> ::= <L> <E> ';'). A production which begins a list should have
+// handles of that production after <L> and a separator (<L> ::= <E>),
+// or after <L> when a separator ends it (<L> ::= <E> ';' or <L> ::= ).
+// Otherwise a list is parsed on a calling thread.
+// A list should end with a close of nesting or an end of a text.
+// When a chunk fails, a list is parsed again on a calling thread so that
+// an error is reported as Parser does.
+class CppAuParserDecl ParallelParser {
+ public:
+  explicit ParallelParser(const Grammar& grammar);
+  ~ParallelParser();
+
+  // ids are as Symbol::GetID. e.g. ("<Values>", ",")
+  bool SetList(const char* symbol_id, const char* separator_id);
+  // a pair of symbols which nests. e.g. ("[", "]")
+  bool AddNesting(const char* open_id, const char* close_id);
+
+  // a list is split only when it has at least two chunks of this size.
+  void SetChunkSize(size_t size);
+  // threads including a calling thread. 0 for hardware concurrency.
+  void SetThreadCount(size_t count);
+
+  bool Parse(const byte* buf, size_t size);
+  TreeNode* GetResult() const;
+
+  const ParseErrorInfo& GetErrorInfo() const;
+  size_t GetSplitCount() const;
+
+ private:
+  struct List {
+    const Symbol* symbol;
+    const Production* production;
+    int separator;
+    bool terminated;
+  };
+
+  struct Chunk {
+    size_t offset;
+    std::pair<int, int> position;
+    size_t end;
+    TreeNode* result;
+    Token separator;
+  };
+
+  struct Worker;
+
+  bool Split(const List& list, const Token& token);
+  void RunWorker(Worker* worker, const List* list, const LALRState* state);
+  bool RunChunk(Worker* worker, const List& list, const LALRState* state,
+                Chunk* chunk);
+  TreeNodeNonTerminal* Stitch(const List& list);
+
+ private:
+  const Grammar& grammar_;
+  Parser parser_;
+  Lexer scanner_;
+  TreeBuilder builder_;
+  std::vector<List> lists_;
+  std::vector<int> nesting_;
+  size_t chunk_size_;
+  size_t thread_count_;
+  size_t threads_;
+
+  const byte* buf_;
+  size_t size_;
+  size_t split_count_;
+  // a list is not scanned again until a parser passes it
+  size_t scan_until_;
+
+  std::vector<std::pair<size_t, size_t> > separators_;
+  std::vector<Chunk> chunks_;
+  std::atomic<size_t> next_chunk_;
+  std::atomic<bool> failed_;
+  std::vector<std::unique_ptr<Worker> > workers_;
+
+  CPPAUPARSER_UNCOPYABLE(ParallelParser);
+};
+
+}  // namespace cppauparser
+
+#endif  // _CPPAUPARSER_PARALLEL_H_
@@ -7,11 +7,16 @@
 #include "grammar.h"
 #include "lexer.h"
 #include <vector>
+#include <new>
+#include <type_traits>
 #include <memory>
 #include <utility>
 
 namespace cppauparser {
 
+class TokenPipeline;
+struct ParseBudget;
+
 namespace ParseResultType {
 enum T {
   kAccept = 1,
@@ -19,9 +24,152 @@ enum T {
   kReduce = 3,
   kReduceEliminated = 4,
   kError = 5,
+  kNeedMoreInput = 6,
+  kSuspended = 7,
+};
+};
+
+namespace ParseEventMask {
+enum T {
+  kAccept = 1 << ParseResultType::kAccept,
+  kShift = 1 << ParseResultType::kShift,
+  kReduce = 1 << ParseResultType::kReduce,
+  kReduceEliminated = 1 << ParseResultType::kReduceEliminated,
+  kError = 1 << ParseResultType::kError,
+  kNeedMoreInput = 1 << ParseResultType::kNeedMoreInput,
+  kSuspended = 1 << ParseResultType::kSuspended,
+  kAll = 0xFFFF
 };
 };
 
+// ParseAll calls a handler only for events in kEvents.
+// specialize it for a handler which ignores some events so that
+// no call is made for them.
+template<typename T>
+struct ParseHandlerTraits {
+  static const int kEvents = ParseEventMask::kAll;
+};
+
+#define CPPAUPARSER_HANDLER_WANTS(T, ret) \
+  (cppauparser::ParseHandlerTraits<T>::kEvents == \
+       cppauparser::ParseEventMask::kAll || \
+   (cppauparser::ParseHandlerTraits<T>::kEvents & (1 << (ret))) != 0)
+
+// ParseMemory is a fixed memory region given by a caller.
+// a parser and a tree builder made on it take what they need while parsing
+// only from it and fail with kOutOfMemory instead of growing.
+// memory is handed out by bumping an offset and comes back only by Reset.
+class CppAuParserDecl ParseMemory {
+ public:
+  ParseMemory(void* buf, size_t size);
+
+  // NULL when a region is exhausted. a block is aligned to 16 bytes.
+  void* Allocate(size_t size);
+
+  // gives back blocks allocated after GetUsedBytes returned used.
+  // e.g. take a mark after making a parser and reset a tree arena
+  // to it before each parse keeping a parser stack.
+  void Reset(size_t used = 0);
+
+  size_t GetUsedBytes() const;
+  size_t GetFreeBytes() const;
+
+ private:
+  byte* buf_;
+  size_t size_;
+  size_t used_;
+
+  CPPAUPARSER_UNCOPYABLE(ParseMemory);
+};
+
+// an allocator of parser containers. it takes memory from a ParseMemory
+// when one is given and from a heap otherwise. a container on a region
+// should never grow beyond what it reserved.
+template<typename T>
+class ParseAllocator {
+ public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  template<typename U>
+  struct rebind {
+    typedef ParseAllocator<U> other;
+  };
+
+ public:
+  explicit ParseAllocator(ParseMemory* memory = NULL_PTR)
+      : memory_(memory) {
+  }
+
+  template<typename U>
+  ParseAllocator(const ParseAllocator<U>& a)
+      : memory_(a.GetMemory()) {
+  }
+
+  // a container never gets NULL. an exhausted region throws as operator new
+  // does, which happens only when a container grows beyond its reservation.
+  T* allocate(size_t n) {
+    if (memory_) {
+      void* p = memory_->Allocate(n * sizeof(T));
+      if (p == NULL_PTR) {
+        throw std::bad_alloc();
+      }
+      return static_cast<T*>(p);
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t) {
+    if (memory_ == NULL_PTR) {
+      ::operator delete(p);
+    }
+  }
+
+  void construct(T* p, const T& v) {
+    new (p) T(v);
+  }
+
+  void destroy(T* p) {
+    p->~T();
+  }
+
+  size_t max_size() const {
+    return static_cast<size_t>(-1) / sizeof(T);
+  }
+
+  T* address(T& v) const {
+    return &v;
+  }
+
+  const T* address(const T& v) const {
+    return &v;
+  }
+
+  ParseMemory* GetMemory() const {
+    return memory_;
+  }
+
+  template<typename U>
+  bool operator==(const ParseAllocator<U>& a) const {
+    return memory_ == a.GetMemory();
+  }
+
+  template<typename U>
+  bool operator!=(const ParseAllocator<U>& a) const {
+    return memory_ != a.GetMemory();
+  }
+
+ private:
+  ParseMemory* memory_;
+};
+
 struct CppAuParserDecl ParseItem {
   const LALRState* state;
   const Production* production;
@@ -32,10 +180,12 @@ struct CppAuParserDecl ParseItem {
   utf8_string GetString() const;
 };
 
+typedef std::vector<ParseItem, ParseAllocator<ParseItem> > ParseItemVector;
+
 struct CppAuParserDecl ParseReduction {
   const Production* production;
   ParseItem* head;
-  std::vector<ParseItem>* handles;
+  ParseItemVector* handles;
 
  public:
   utf8_string GetString() const;
@@ -46,7 +196,18 @@ enum T {
     kNone = 0,
     kLexicalError = 1,
     kSyntaxError = 2,
-    kInternalError = 3
+    kInternalError = 3,
+    kCancelled = 4,
+    kOutOfMemory = 5,
+    kLimitExceeded = 6
+};
+};
+
+// what ParseRecords does when a record fails
+namespace RecordErrorMode {
+enum T {
+  kStop = 0,
+  kSkipLine = 1
 };
 };
 
@@ -64,9 +225,58 @@ struct CppAuParserDecl ParseErrorInfo {
   utf8_string GetString() const;
 };
 
+// limits of a parse to keep memory for a hostile text bounded.
+// a parse going over one fails with kLimitExceeded. 0 is no limit.
+struct CppAuParserDecl ParseLimits {
+  // items on a parser stack
+  size_t max_depth;
+  // tokens read since a load. (or since a start of a record)
+  size_t max_tokens;
+  // bytes of a token. in a stream, also bytes pending for a token
+  // not decided yet.
+  size_t max_lexeme;
+  // bytes of a tree. checked by TreeBuilder and SimplifiedTreeBuilder.
+  size_t max_tree_bytes;
+
+ public:
+  ParseLimits();
+};
+
+// a saved state of a parser and its lexer.
+// checkpoints of one parse share their stacks. a checkpoint keeps only items
+// pushed after the bottom part which is still the same as its parent's.
+class CppAuParserDecl ParseCheckpoint {
+ public:
+  ParseCheckpoint();
+
+  size_t GetOffset() const;
+  std::pair<int, int> GetPosition() const;
+  size_t GetDepth() const;
+
+ private:
+  friend class Parser;
+
+  std::shared_ptr<const ParseCheckpoint> parent_;
+  size_t shared_;
+  std::vector<ParseItem> tail_;
+  size_t depth_;
+  const LALRState* state_;
+  Token token_;
+  bool token_used_;
+  LexerState lexer_;
+};
+
 class CppAuParserDecl Parser {
  public:
   explicit Parser(const Grammar& grammar);
+
+  // a parser which keeps its stack on a fixed memory. a stack is reserved
+  // for max_depth items (less when memory can't hold it) and a deeper parse
+  // fails with kOutOfMemory. when memory can't hold even one item, every
+  // load fails with kOutOfMemory. error info doesn't carry expected symbols.
+  // a lexer's stack of nested groups, streams, pipelines, checkpoints and
+  // Validate still use a heap.
+  Parser(const Grammar& grammar, ParseMemory* memory, size_t max_depth);
   ~Parser();
 
  public:
@@ -75,19 +285,74 @@ class CppAuParserDecl Parser {
   bool LoadBuffer(const byte* buf, size_t size);
   void ResetCursor();
 
+  // restarts at an offset of a loaded text with a state at a bottom of
+  // a stack, as if a text before it was parsed up to the state.
+  // for drivers which parse only a part of a text.
+  void ResetCursor(const LALRState* state, size_t offset,
+                   std::pair<int, int> position);
+
+  // reads tokens from a pipeline instead of an own lexer until a next load.
+  // a pipeline should be loaded with a text already. ResetCursor,
+  // checkpoints and ShiftSubtree need an own lexer and can't be used.
+  bool LoadPipeline(TokenPipeline* pipeline);
+
   std::shared_ptr<LexerBuffer> ReleaseBuffer();
 
+  // push interface for a text arriving in pieces.
+  // Feed appends bytes and parses as far as they allow, returning
+  // kNeedMoreInput when it stops at a token or a group not complete yet.
+  // Finish tells the end of a text. Feed after Finish starts a new text.
+  bool LoadStream();
+  ParseResultType::T Feed(const byte* buf, size_t size);
+  ParseResultType::T Finish();
+
+  template<typename T>
+  ParseResultType::T Feed(const byte* buf, size_t size, const T& handler) {
+    FeedLexer(buf, size);
+    return ParseAll(handler);
+  }
+
+  template<typename T>
+  ParseResultType::T Feed(const byte* buf, size_t size, T& handler) {
+    FeedLexer(buf, size);
+    return ParseAll(handler);
+  }
+
+  template<typename T>
+  ParseResultType::T Finish(const T& handler) {
+    lexer_.Finish();
+    return ParseAll(handler);
+  }
+
+  template<typename T>
+  ParseResultType::T Finish(T& handler) {
+    lexer_.Finish();
+    return ParseAll(handler);
+  }
+
   ParseResultType::T ParseStep();
   ParseResultType::T ParseReduce();
   ParseResultType::T ParseAll();
+  ParseResultType::T ParseFor(const ParseBudget& budget);
+
+  // checks only whether a text is accepted. it loads a buffer and
+  // parses it keeping nothing but states. on failure GetErrorInfo
+  // is filled as ParseAll does.
+  bool Validate(const byte* buf, size_t size);
 
   template<typename T>
   ParseResultType::T ParseAll(const T& handler) {
     while (true) {
       ParseResultType::T ret = ParseStep();
-      handler(ret, *this);
+      if (CPPAUPARSER_HANDLER_WANTS(T, ret)) {
+        handler(ret, *this);
+        if (abort_ != ParseErrorType::kNone) {
+          return Fail(abort_);
+        }
+      }
       if (ret == ParseResultType::kAccept ||
-          ret == ParseResultType::kError) {
+          ret == ParseResultType::kError ||
+          ret == ParseResultType::kNeedMoreInput) {
         return ret;
       }
     }
@@ -97,17 +362,67 @@ class CppAuParserDecl Parser {
   ParseResultType::T ParseAll(T& handler) {
     while (true) {
       ParseResultType::T ret = ParseStep();
-      handler(ret, *this);
+      if (CPPAUPARSER_HANDLER_WANTS(T, ret)) {
+        handler(ret, *this);
+        if (abort_ != ParseErrorType::kNone) {
+          return Fail(abort_);
+        }
+      }
       if (ret == ParseResultType::kAccept ||
-          ret == ParseResultType::kError) {
+          ret == ParseResultType::kError ||
+          ret == ParseResultType::kNeedMoreInput) {
         return ret;
       }
     }
   }
 
+  // with a budget. (see budget.h)
+  template<typename T>
+  ParseResultType::T ParseAll(const T& handler, const ParseBudget& budget);
+  template<typename T>
+  ParseResultType::T ParseAll(T& handler, const ParseBudget& budget);
+
+  // record stream. a loaded text is a sequence of documents of a start
+  // symbol, e.g. concatenated or newline delimited JSON. a record ends
+  // where a next token can't follow it but an end of a text could.
+  // records are parsed one after another without a new load, a handler
+  // gets events of every record as ParseAll and callback(ret, parser) is
+  // called after each record with kAccept or kError.
+  // kSkipLine goes on from a next line after a failed record. (or from
+  // a line of an error when it's not a first line of a record)
+  // returns kAccept at an end of a text or kError when it stops.
+  // a text should be given by LoadFile, LoadString or LoadBuffer.
+  template<typename T, typename C>
+  ParseResultType::T ParseRecords(const T& handler, const C& callback,
+                                  RecordErrorMode::T mode =
+                                      RecordErrorMode::kStop) {
+    return ParseRecordsWith<const T>(handler, callback, mode);
+  }
+
+  template<typename T, typename C>
+  ParseResultType::T ParseRecords(T& handler, const C& callback,
+                                  RecordErrorMode::T mode =
+                                      RecordErrorMode::kStop) {
+    return ParseRecordsWith<T>(handler, callback, mode);
+  }
+
+  // limits are kept over loads. Validate checks only depth and tokens.
+  void SetLimits(const ParseLimits& limits);
+  const ParseLimits& GetLimits() const;
+
+  // stops a parse from a handler. ParseAll returns kError with
+  // a given type as soon as a handler returns. a next load clears it.
+  void Abort(ParseErrorType::T type) const;
+
+  ParseErrorType::T GetAbortType() const {
+    return abort_;
+  }
+
+  size_t GetMaxDepth() const;
+
   const LALRState* GetState() const;
   const ParseItem& GetTop() const;
-  const std::vector<ParseItem>& GetStack() const;
+  const ParseItemVector& GetStack() const;
   const Token& GetToken() const;
   const ParseReduction& GetReduction() const;
   const ParseErrorInfo& GetErrorInfo() const;
@@ -116,31 +431,244 @@ class CppAuParserDecl Parser {
   int GetColumn() const;
   std::pair<int, int> GetPosition() const;
 
+  const Lexer& GetLexer() const;
+  const Grammar& GetGrammar() const;
+
+  // snapshots. Restore also keeps recorded checkpoints only up to
+  // a restored one because following ones will be recorded again.
+  // a checkpoint is recorded automatically every n tokens when
+  // an interval is set. (0 turns it off)
+  std::shared_ptr<const ParseCheckpoint> Snapshot();
+  bool Restore(const std::shared_ptr<const ParseCheckpoint>& checkpoint);
+  void SetCheckpointInterval(size_t tokens);
+  const std::vector<std::shared_ptr<const ParseCheckpoint>>&
+      GetCheckpoints() const;
+  // the last recorded checkpoint at or before an offset
+  std::shared_ptr<const ParseCheckpoint> FindCheckpoint(size_t offset) const;
+
+  // low-level interface for drivers that splice subtrees of a previous
+  // parse into the current one. (see IncrementalParser)
+  const Token& ReadLookahead();
+  bool ShiftSubtree(const Production* production, void* data,
+                    size_t end_offset, std::pair<int, int> end_position);
+
+  // a state of an item at a depth from a top of a stack
+  const LALRState* GetStateAt(size_t depth) const {
+    return stack_[stack_.size() - 1 - depth].state;
+  }
+
  private:
-  void ResetState();
+  friend class ParserDriver;
+
+  // ParseStep for IsLALRDirect of a grammar or not
+  template<bool kDirect>
+  ParseResultType::T ParseStepIn();
+
+  // reads a next lookahead when a current one was used. false when
+  // a parse can't go on and ret tells why. (kNeedMoreInput or kError)
+  bool ReadNextToken(ParseResultType::T* ret) {
+    ReadToken(&token_);
+    if (token_.symbol == NULL_PTR) {
+      *ret = (lexer_.GetPendingSize() > lexeme_limit_)
+             ? Fail(ParseErrorType::kLimitExceeded)
+             : ParseResultType::kNeedMoreInput;
+      return false;
+    }
+    token_used_ = false;
+    if (++token_count_ > token_limit_ ||
+        token_.lexeme.size() > lexeme_limit_) {
+      *ret = Fail(ParseErrorType::kLimitExceeded);
+      return false;
+    }
+    if (checkpoint_countdown_ != 0 && --checkpoint_countdown_ == 0) {
+      checkpoints_.push_back(Snapshot());
+    }
+    return true;
+  }
+
+  ParseResultType::T DoShift(int state) {
+    if (stack_.size() >= stack_limit_) {
+      return FailDepth();
+    }
+    state_ = grammar_.GetLALRState(state);
+    ParseItem item = { state_, NULL_PTR, token_, NULL_PTR };
+    stack_.push_back(item);
+    token_used_ = true;
+    return ParseResultType::kShift;
+  }
+
+  ParseResultType::T DoReduce(int production, int state) {
+    const Production& p = grammar_.productions[production];
+    size_t n = p.handles.size();
+    if (n == 0 && stack_.size() >= stack_limit_) {
+      return FailDepth();
+    }
+    reduction_handles_.assign(stack_.end() - n, stack_.end());
+    stack_.resize(stack_.size() - n);
+    if (stack_.size() < stack_low_) {
+      stack_low_ = stack_.size();
+    }
+    state_ = grammar_.GetLALRState(state);
+    ParseItem item = { state_, &p, Token(), NULL_PTR };
+    stack_.push_back(item);
+    reduction_.production = &p;
+    reduction_.handles = &reduction_handles_;
+    reduction_.head = &stack_.back();
+    return ParseResultType::kReduce;
+  }
+
+  // kSyntaxError reports a lexical error instead for an error token
+  ParseResultType::T Fail(ParseErrorType::T type);
+
+  // false when a stack can't be made on a fixed memory
+  bool ResetState();
   void ReadToken(Token* token);
+  // kLimitExceeded or kOutOfMemory for a stack which can't grow
+  ParseResultType::T FailDepth();
+  void FeedLexer(const byte* buf, size_t size);
+  ParseResultType::T ParseStepWithin(const ParseBudget& budget, size_t steps);
+
+  template<typename T, typename C>
+  ParseResultType::T ParseRecordsWith(T& handler, const C& callback,
+                                      RecordErrorMode::T mode) {
+    while (true) {
+      const Token begin = ReadLookahead();
+      if (begin.symbol == NULL_PTR) {
+        return ParseResultType::kNeedMoreInput;
+      }
+      if (begin.symbol->type == SymbolType::kEndOfFile) {
+        return ParseResultType::kAccept;
+      }
+
+      Token next;
+      bool ended = false;
+      ParseResultType::T ret;
+      while (true) {
+        ret = ParseStep();
+        if (ret == ParseResultType::kError && ended == false &&
+            EndRecord(&next)) {
+          // finish a record as if a text ended here
+          ended = true;
+          continue;
+        }
+        if (CPPAUPARSER_HANDLER_WANTS(T, ret)) {
+          handler(ret, *this);
+          if (abort_ != ParseErrorType::kNone) {
+            return Fail(abort_);
+          }
+        }
+        if (ret == ParseResultType::kAccept ||
+            ret == ParseResultType::kError ||
+            ret == ParseResultType::kNeedMoreInput) {
+          break;
+        }
+      }
+
+      if (ret == ParseResultType::kNeedMoreInput) {
+        return ret;
+      }
+      callback(ret, *this);
+      if (abort_ != ParseErrorType::kNone) {
+        return Fail(abort_);
+      }
+      if (ret == ParseResultType::kAccept) {
+        if (ended == false) {
+          return ParseResultType::kAccept;
+        }
+        NextRecord(next);
+      } else if (mode == RecordErrorMode::kSkipLine) {
+        SkipRecord(begin);
+      } else {
+        return ret;
+      }
+    }
+  }
+
+  // whether a text could end at a current lookahead. states pushed by
+  // reductions are kept in state_stack_ and a stack is not changed.
+  bool CanAccept();
+  bool EndRecord(Token* next);
+  void NextRecord(const Token& next);
+  void SkipRecord(const Token& begin);
 
  private:
   const Grammar& grammar_;
   Lexer lexer_;
+  TokenPipeline* pipeline_;
+  ParseMemory* memory_;
   bool trim_reduction_;
+  mutable ParseErrorType::T abort_;
+
+  // limits are kept as maximum values for no limit so that each of them
+  // is checked by a single compare. a stack limit is also a capacity of
+  // a stack on a fixed memory.
+  ParseLimits limits_;
+  size_t stack_limit_;
+  size_t token_limit_;
+  size_t lexeme_limit_;
+  size_t token_count_;
 
   const LALRState* state_;
-  std::vector<ParseItem> stack_;
-  std::vector<ParseItem> reduction_handles_;
+  ParseItemVector stack_;
+  ParseItemVector reduction_handles_;
+  std::vector<const LALRState*> state_stack_;
   Token token_;
   bool token_used_;
   ParseReduction reduction_;
   ParseErrorInfo error_info_;
 
+  // lowest stack size since last_checkpoint_ was taken
+  std::shared_ptr<const ParseCheckpoint> last_checkpoint_;
+  size_t stack_low_;
+  size_t checkpoint_interval_;
+  size_t checkpoint_countdown_;
+  std::vector<std::shared_ptr<const ParseCheckpoint>> checkpoints_;
+
   CPPAUPARSER_UNCOPYABLE(Parser);
 };
 
+// primitives for drivers which decide actions by themselves, i.e. parsers
+// generated by auparser-tool and ParseTape::Replay. each of them does only
+// what ParseStep does for a decided action.
+class ParserDriver {
+ public:
+  // -1 when a stream needs more input and -2 when a token goes over
+  // limits. (a parser has failed already)
+  static int ReadLookaheadSymbol(Parser& parser) {
+    if (parser.token_used_) {
+      ParseResultType::T ret;
+      if (parser.ReadNextToken(&ret) == false) {
+        return (ret == ParseResultType::kNeedMoreInput) ? -1 : -2;
+      }
+    }
+    return parser.token_.symbol->index;
+  }
+
+  // sets a lookahead as if it was read
+  static void SetLookahead(Parser& parser, const Token& token) {
+    parser.token_ = token;
+    parser.token_used_ = false;
+  }
+
+  static ParseResultType::T Shift(Parser& parser, int state) {
+    return parser.DoShift(state);
+  }
+
+  static ParseResultType::T Reduce(Parser& parser, int production,
+                                   int state) {
+    return parser.DoReduce(production, state);
+  }
+
+  static ParseResultType::T Fail(Parser& parser, ParseErrorType::T type) {
+    return parser.Fail(type);
+  }
+};
+
 class CppAuParserDecl ProductionHandler {
  public:
   ProductionHandler(const Grammar& grammar);
 
-  typedef void*(*Handler)(const std::vector<ParseItem>&);
+  typedef void*(*Handler)(const ParseItemVector&);
   Handler GetHandler(const char* production_id);
   bool SetHandler(const char* production_id, Handler handler);
 
@@ -154,7 +682,13 @@ class CppAuParserDecl ProductionHandler {
   void* result_;
 };
 
-#define PH_ARGS const std::vector<cppauparser::ParseItem>& c
+template<>
+struct ParseHandlerTraits<ProductionHandler> {
+  static const int kEvents =
+      ParseEventMask::kReduce | ParseEventMask::kAccept;
+};
+
+#define PH_ARGS const cppauparser::ParseItemVector& c
 
 #define PH_ON(ph, p, e) { \
     struct LambdaDummy { \
@@ -163,6 +697,59 @@ class CppAuParserDecl ProductionHandler {
     (ph).SetHandler((p), &LambdaDummy::h); \
   }
 
+// a handler keeping typed values on its own stack instead of ParseItem::data.
+// Actions should have following members which are called directly
+// so that they can be inlined into a parse loop:
+//   V Shift(const Token& token);
+//   V Reduce(int production, V* c);  // c[0..n) are values of handles
+// production indexes can be taken from a header made by auparser-tool show -H.
+template<typename V, typename Actions>
+class TypedProductionHandler {
+ public:
+  TypedProductionHandler() {
+  }
+
+  explicit TypedProductionHandler(const Actions& actions)
+      : actions_(actions) {
+  }
+
+  void operator()(ParseResultType::T ret, const Parser& parser) {
+    if (ret == ParseResultType::kShift) {
+      values_.push_back(actions_.Shift(parser.GetToken()));
+    } else if (ret == ParseResultType::kReduce) {
+      const ParseReduction& reduction = parser.GetReduction();
+      size_t n = reduction.handles->size();
+      V* c = values_.data() + (values_.size() - n);
+      V v = actions_.Reduce(reduction.production->index, c);
+      values_.erase(values_.end() - n, values_.end());
+      values_.push_back(std::move(v));
+    }
+  }
+
+  void Clear() {
+    values_.clear();
+  }
+
+  // valid after kAccept
+  const V& GetResult() const {
+    return values_.back();
+  }
+
+  Actions& GetActions() {
+    return actions_;
+  }
+
+ private:
+  Actions actions_;
+  std::vector<V> values_;
+};
+
+template<typename V, typename Actions>
+struct ParseHandlerTraits<TypedProductionHandler<V, Actions> > {
+  static const int kEvents =
+      ParseEventMask::kShift | ParseEventMask::kReduce;
+};
+
 }  // namespace cppauparser
 
 #endif  // _CPPAUPARSER_PARSER_H_
@@ -0,0 +1,96 @@
+// Copyright 2012 Esun Kim
+
+#ifndef _CPPAUPARSER_PIPELINE_H_
+#define _CPPAUPARSER_PIPELINE_H_
+
+#include "base.h"
+#include "grammar.h"
+#include "lexer.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <utility>
+
+namespace cppauparser {
+
+// TokenPipeline runs a lexer on its own thread and hands tokens to a parser
+// through a single-producer/single-consumer ring. Each side publishes its
+// index only every batch tokens (or when it has to wait) so that cores don't
+// exchange a cache line per token. Noise is dropped on the lexer side.
+// A parser reads tokens from it after Parser::LoadPipeline.
+class CppAuParserDecl TokenPipeline {
+ public:
+  // capacity is rounded up to a power of two
+  explicit TokenPipeline(const Grammar& grammar,
+                         size_t capacity = 4096, size_t batch = 64);
+  ~TokenPipeline();
+
+  bool LoadFile(const PATHCHAR* file_path);
+  bool LoadString(const char* buf);
+  bool LoadBuffer(const byte* buf, size_t size);
+  void Stop();
+
+  std::shared_ptr<LexerBuffer> ReleaseBuffer();
+
+  // consumer side. a position is where the lexer was after a last token.
+  void ReadToken(Token* token) {
+    if (read_ == read_limit_ && Wait() == false) {
+      *token = last_token_;
+      return;
+    }
+    const Slot& slot = ring_[read_ & mask_];
+    *token = slot.token;
+    position_ = slot.position;
+    read_ += 1;
+    if (read_ - read_published_ >= batch_) {
+      read_published_ = read_;
+      head_.store(read_, std::memory_order_release);
+    }
+  }
+
+  std::pair<int, int> GetPosition() const {
+    return position_;
+  }
+
+ private:
+  struct Slot {
+    Token token;
+    std::pair<int, int> position;
+  };
+
+  void Start();
+  void Run();
+  bool Wait();
+
+ private:
+  const Grammar& grammar_;
+  Lexer lexer_;
+  std::vector<Slot> ring_;
+  size_t mask_;
+  size_t batch_;
+  std::thread thread_;
+  std::atomic<bool> stop_;
+  std::atomic<bool> finished_;
+
+  // indexes grow forever and are masked to get a slot.
+  // each one is on its own cache line.
+  char pad0_[64];
+  std::atomic<size_t> head_;
+  char pad1_[64];
+  std::atomic<size_t> tail_;
+  char pad2_[64];
+
+  // consumer only
+  size_t read_;
+  size_t read_limit_;
+  size_t read_published_;
+  Token last_token_;
+  std::pair<int, int> position_;
+
+  CPPAUPARSER_UNCOPYABLE(TokenPipeline);
+};
+
+}  // namespace cppauparser
+
+#endif  // _CPPAUPARSER_PIPELINE_H_
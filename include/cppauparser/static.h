@@ -0,0 +1,508 @@
+// Copyright 2012 Esun Kim
+
+#ifndef _CPPAUPARSER_STATIC_H_
+#define _CPPAUPARSER_STATIC_H_
+
+#include "base.h"
+#include "strs.h"
+#include "grammar.h"
+#include "parser.h"
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <utility>
+
+namespace cppauparser {
+
+// StaticLexer and StaticParser run on tables compiled into a program by
+// "auparser-tool tables". No Grammar is loaded at runtime and every table
+// lookup is a load from a constant array the compiler can see.
+//
+// A table type is a struct generated by the tool which has
+//   kSymbolCount, kSymbolEOF, kSymbolError, kDfaInit, kLalrInit
+//   symbol_type[], symbol_id[], symbol_group[]
+//   dfa_jmp[][0x80], dfa_accept[], dfa_range_begin[], dfa_ranges[]
+//   lalr_action[][symbol count]
+//   production_head[], production_size[]
+//   groups[], group_nesting[]
+// lalr_action packs (LALRActionType << 16 | target) and 0 means no action.
+
+struct StaticJmpRange {
+  uint16_t range_from;
+  uint16_t range_to;
+  int16_t target;
+};
+
+struct StaticGroup {
+  int container;
+  int start;
+  int end;
+  int advance_mode;
+  int ending_mode;
+  int nesting_begin;
+  int nesting_end;
+};
+
+struct StaticToken {
+  int symbol;
+  utf8_substring lexeme;
+  std::pair<int, int> position;
+
+ public:
+  StaticToken()
+      : symbol(-1),
+        position(std::make_pair(0, 0)) {
+  }
+};
+
+template<typename Tables>
+class StaticLexer {
+ public:
+  StaticLexer()
+      : buf_(NULL_PTR),
+        buf_cur_(NULL_PTR),
+        buf_end_(NULL_PTR),
+        line_(1),
+        column_(1) {
+  }
+
+  // a buffer is not copied and should be kept alive while lexing.
+  void LoadBuffer(const byte* buf, size_t size) {
+    buf_ = buf;
+    buf_end_ = buf + size;
+    ResetCursor();
+  }
+
+  void LoadString(const char* buf) {
+    LoadBuffer((const byte*)buf, strlen(buf));
+  }
+
+  void ResetCursor() {
+    buf_cur_ = buf_;
+    line_ = 1;
+    column_ = 1;
+    group_stack_.clear();
+  }
+
+  void ReadToken(StaticToken* token) {
+    while (true) {
+      const byte* peek = PeekToken(token);
+      int symbol_type = Tables::symbol_type[token->symbol];
+
+      int group = -1;
+      bool nest_group = false;
+      if (symbol_type == SymbolType::kGroupStart) {
+        group = Tables::symbol_group[token->symbol];
+        if (group_stack_.empty()) {
+          nest_group = true;
+        } else {
+          const StaticGroup& top = Tables::groups[group_stack_.back().group];
+          for (int i = top.nesting_begin; i < top.nesting_end; ++i) {
+            if (Tables::group_nesting[i] == group) {
+              nest_group = true;
+              break;
+            }
+          }
+        }
+      }
+
+      if (nest_group) {
+        // into nested
+        AdvanceBuffer(peek);
+        Group g = { group, token->lexeme };
+        group_stack_.push_back(g);
+      } else if (group_stack_.empty()) {
+        // token in plain
+        AdvanceBuffer(peek);
+        return;
+      } else if (Tables::groups[group_stack_.back().group].end ==
+                 token->symbol) {
+        // out of nested
+        Group pop = group_stack_.back();
+        group_stack_.pop_back();
+        const StaticGroup& g = Tables::groups[pop.group];
+        if (g.ending_mode == EndingModeType::kClosed) {
+          pop.text = utf8_substring(
+              pop.text.c_str(),
+              token->lexeme.c_str() - pop.text.c_str() + token->lexeme.size());
+          AdvanceBuffer(peek);
+        } else {
+          pop.text = utf8_substring(
+              pop.text.c_str(),
+              token->lexeme.c_str() - pop.text.c_str());
+        }
+        if (group_stack_.empty()) {
+          token->symbol = g.container;
+          token->lexeme = pop.text;
+        }
+        return;
+      } else if (symbol_type == SymbolType::kEndOfFile) {
+        // EOF in nested
+        return;
+      } else {
+        // token in nested
+        if (Tables::groups[group_stack_.back().group].advance_mode ==
+            AdvanceModeType::kToken) {
+          AdvanceBuffer(peek);
+        } else {
+          AdvanceBuffer(buf_cur_ + 1);
+        }
+      }
+    }
+  }
+
+  std::pair<int, int> GetPosition() const {
+    return std::make_pair(line_, column_);
+  }
+
+ private:
+  // same as Lexer::MatchToken but on static tables.
+  int MatchToken(const byte** hit_end, const byte** end) const {
+    int state = Tables::kDfaInit;
+    const byte* cur = buf_cur_;
+    int hit_symbol = -1;
+    const byte* hit_cur = NULL_PTR;
+    while (cur < buf_end_) {
+      int32_t c = *cur;
+      int target;
+      if (c < 0x80) {
+        cur += 1;
+        target = Tables::dfa_jmp[state][c];
+        if (target == -2) {
+          hit_cur = cur;
+          continue;
+        }
+      } else {
+        if (buf_end_ - cur < ((c < 0xE0) ? 2 : (c < 0xF0) ? 3 : 4)) {
+          cur = buf_end_;
+          break;
+        }
+        if (c < 0xE0) {
+          c = ((c & 0x1F) << 6) | (cur[1] & 0x3F);
+          cur += 2;
+        } else if (c < 0xF0) {
+          c = ((c & 0x0F) << 12) | ((cur[1] & 0x3F) << 6) |
+              (cur[2] & 0x3F);
+          cur += 3;
+        } else {
+          c = 0xFFFF;
+          cur += 4;
+        }
+        target = -1;
+        for (int j = Tables::dfa_range_begin[state],
+                 j_end = Tables::dfa_range_begin[state + 1];
+             j < j_end; ++j) {
+          const StaticJmpRange& r = Tables::dfa_ranges[j];
+          if (c >= r.range_from && c <= r.range_to) {
+            target = r.target;
+            break;
+          }
+        }
+        if (target == -2) {
+          continue;
+        }
+      }
+      if (target == -3) {
+        continue;
+      } else if (target == -1) {
+        break;
+      }
+      state = target;
+      if (Tables::dfa_accept[state] != -1) {
+        hit_symbol = Tables::dfa_accept[state];
+        hit_cur = cur;
+      }
+    }
+    *hit_end = hit_cur;
+    *end = cur;
+    return hit_symbol;
+  }
+
+  const byte* PeekToken(StaticToken* token) const {
+    const byte* hit_cur;
+    const byte* cur;
+    int hit_symbol = MatchToken(&hit_cur, &cur);
+    token->position = GetPosition();
+    if (hit_symbol != -1) {
+      token->symbol = hit_symbol;
+      token->lexeme = utf8_substring(buf_cur_, hit_cur - buf_cur_);
+      return hit_cur;
+    }
+    if (cur == buf_cur_) {
+      token->symbol = Tables::kSymbolEOF;
+      token->lexeme = utf8_substring();
+    } else {
+      token->symbol = Tables::kSymbolError;
+      token->lexeme = utf8_substring(buf_cur_, cur - buf_cur_);
+    }
+    return cur;
+  }
+
+  void AdvanceBuffer(const byte* buf_next) {
+    // same line counting rule as Lexer::AdvanceBuffer
+    for (; buf_cur_ < buf_next; ++buf_cur_) {
+      if (*buf_cur_ == 0x13) {
+        line_ += 1;
+        column_ = 1;
+      } else {
+        column_ += 1;
+      }
+    }
+  }
+
+ private:
+  struct Group {
+    int group;
+    utf8_substring text;
+  };
+
+  const byte* buf_;
+  const byte* buf_cur_;
+  const byte* buf_end_;
+  int line_;
+  int column_;
+  std::vector<Group> group_stack_;
+
+  CPPAUPARSER_UNCOPYABLE(StaticLexer);
+};
+
+template<typename Tables>
+class StaticParser {
+ public:
+  struct Item {
+    int state;
+    int production;
+    StaticToken token;
+    mutable void* data;
+  };
+
+  struct Reduction {
+    int production;
+    Item* head;
+    std::vector<Item>* handles;
+  };
+
+  struct ErrorInfo {
+    ParseErrorType::T type;
+    std::pair<int, int> position;
+    int state;
+    StaticToken token;
+
+   public:
+    ErrorInfo()
+        : type(ParseErrorType::kNone),
+          position(std::make_pair(0, 0)),
+          state(-1) {
+    }
+
+    // the same text as ParseErrorInfo::GetString
+    utf8_string GetString() const {
+      switch (type) {
+      case ParseErrorType::kLexicalError:
+        return utf8_format("LexicalError(%d:%d) Token='%s'",
+            token.position.first, token.position.second,
+            token.lexeme.get_string().c_str());
+
+      case ParseErrorType::kSyntaxError: {
+          utf8_string e_str;
+          for (int i = 0; i < Tables::kSymbolCount; ++i) {
+            int t = Tables::symbol_type[i];
+            if (Tables::lalr_action[state][i] != 0 &&
+                (t == SymbolType::kTerminal ||
+                 t == SymbolType::kEndOfFile ||
+                 t == SymbolType::kGroupStart ||
+                 t == SymbolType::kGroupEnd)) {
+              if (e_str.empty() == false) {
+                e_str += (const byte*)", ";
+              }
+              e_str += (const byte*)Tables::symbol_id[i];
+            }
+          }
+          return utf8_format("SyntaxError(%d:%d) Token=%s '%s' "
+                             "ExpectedTokens=[%s]",
+            token.position.first, token.position.second,
+            Tables::symbol_id[token.symbol],
+            token.lexeme.get_string().c_str(), e_str.c_str());
+        }
+
+      case ParseErrorType::kInternalError:
+        return utf8_format("InternalError(%d:%d) State=%d",
+            token.position.first, token.position.second, state);
+
+      default:
+        return utf8_format("None");
+      }
+    }
+  };
+
+ public:
+  StaticParser() {
+    ResetState();
+  }
+
+  void LoadBuffer(const byte* buf, size_t size) {
+    lexer_.LoadBuffer(buf, size);
+    ResetState();
+  }
+
+  void LoadString(const char* buf) {
+    lexer_.LoadString(buf);
+    ResetState();
+  }
+
+  void ResetCursor() {
+    lexer_.ResetCursor();
+    ResetState();
+  }
+
+  ParseResultType::T ParseStep() {
+    if (token_used_) {
+      do {
+        lexer_.ReadToken(&token_);
+      } while (Tables::symbol_type[token_.symbol] == SymbolType::kNoise);
+      token_used_ = false;
+    }
+
+    if (Tables::symbol_type[token_.symbol] == SymbolType::kError) {
+      return Fail(ParseErrorType::kLexicalError);
+    }
+
+    int32_t action = Tables::lalr_action[state_][token_.symbol];
+    if (action == 0) {
+      return Fail(ParseErrorType::kSyntaxError);
+    }
+
+    int target = action & 0xFFFF;
+    switch (action >> 16) {
+    case LALRActionType::kShift: {
+        state_ = target;
+        Item item = { state_, -1, token_, NULL_PTR };
+        stack_.push_back(item);
+        token_used_ = true;
+        return ParseResultType::kShift;
+      }
+
+    case LALRActionType::kReduce: {
+        int size = Tables::production_size[target];
+        reduction_handles_.assign(stack_.end() - size, stack_.end());
+        stack_.resize(stack_.size() - size);
+        reduction_.production = target;
+        reduction_.handles = &reduction_handles_;
+        int head = Tables::production_head[target];
+        int32_t goto_action = Tables::lalr_action[stack_.back().state][head];
+        if ((goto_action >> 16) != LALRActionType::kGoto) {
+          return Fail(ParseErrorType::kInternalError);
+        }
+        state_ = goto_action & 0xFFFF;
+        Item item = { state_, target, StaticToken(), NULL_PTR };
+        stack_.push_back(item);
+        reduction_.head = &stack_.back();
+        return ParseResultType::kReduce;
+      }
+
+    case LALRActionType::kAccept:
+      return ParseResultType::kAccept;
+
+    default:
+      return Fail(ParseErrorType::kInternalError);
+    }
+  }
+
+  ParseResultType::T ParseAll() {
+    while (true) {
+      ParseResultType::T ret = ParseStep();
+      if (ret == ParseResultType::kAccept || ret == ParseResultType::kError) {
+        return ret;
+      }
+    }
+  }
+
+  // a handler is called as handler(ret, parser) like Parser::ParseAll.
+  template<typename T>
+  ParseResultType::T ParseAll(const T& handler) {
+    while (true) {
+      ParseResultType::T ret = ParseStep();
+      if (CPPAUPARSER_HANDLER_WANTS(T, ret)) {
+        handler(ret, *this);
+      }
+      if (ret == ParseResultType::kAccept || ret == ParseResultType::kError) {
+        return ret;
+      }
+    }
+  }
+
+  template<typename T>
+  ParseResultType::T ParseAll(T& handler) {
+    while (true) {
+      ParseResultType::T ret = ParseStep();
+      if (CPPAUPARSER_HANDLER_WANTS(T, ret)) {
+        handler(ret, *this);
+      }
+      if (ret == ParseResultType::kAccept || ret == ParseResultType::kError) {
+        return ret;
+      }
+    }
+  }
+
+  int GetState() const {
+    return state_;
+  }
+
+  const Item& GetTop() const {
+    return stack_.back();
+  }
+
+  const StaticToken& GetToken() const {
+    return token_;
+  }
+
+  const Reduction& GetReduction() const {
+    return reduction_;
+  }
+
+  const ErrorInfo& GetErrorInfo() const {
+    return error_info_;
+  }
+
+  std::pair<int, int> GetPosition() const {
+    return lexer_.GetPosition();
+  }
+
+ private:
+  void ResetState() {
+    state_ = Tables::kLalrInit;
+    token_ = StaticToken();
+    token_used_ = true;
+    Item item = { state_, -1, token_, NULL_PTR };
+    stack_.clear();
+    stack_.push_back(item);
+  }
+
+  ParseResultType::T Fail(ParseErrorType::T type) {
+    if (type == ParseErrorType::kSyntaxError &&
+        Tables::symbol_type[token_.symbol] == SymbolType::kError) {
+      type = ParseErrorType::kLexicalError;
+    }
+    error_info_.type = type;
+    error_info_.position = lexer_.GetPosition();
+    error_info_.state = state_;
+    error_info_.token = token_;
+    return ParseResultType::kError;
+  }
+
+ private:
+  StaticLexer<Tables> lexer_;
+  int state_;
+  StaticToken token_;
+  bool token_used_;
+  std::vector<Item> stack_;
+  Reduction reduction_;
+  std::vector<Item> reduction_handles_;
+  ErrorInfo error_info_;
+
+  CPPAUPARSER_UNCOPYABLE(StaticParser);
+};
+
+}  // namespace cppauparser
+
+#endif  // _CPPAUPARSER_STATIC_H_
@@ -0,0 +1,162 @@
+// Copyright 2012 Esun Kim
+
+#ifndef _CPPAUPARSER_TAPE_H_
+#define _CPPAUPARSER_TAPE_H_
+
+#include "base.h"
+#include "grammar.h"
+#include "lexer.h"
+#include "parser.h"
+#include <stdint.h>
+#include <vector>
+#include <utility>
+
+namespace cppauparser {
+
+// ParseTape is a parse recorded as a flat array of 32-bit words in postfix
+// order. Every record takes kRecordSize words.
+//   shift:  symbol << 1 | 0, lexeme offset, lexeme size
+//   reduce: production << 1 | 1, child count, subtree size
+// a subtree size is a number of words of children before a record,
+// so a subtree of a record r is [r - subtree size, r + kRecordSize).
+// the last child of a reduce record r is at r - kRecordSize and
+// a previous sibling of a record c is at GetBegin(c) - kRecordSize.
+// offsets are from a start of a parsed text.
+class CppAuParserDecl ParseTape {
+ public:
+  static const size_t kRecordSize = 3;
+
+  ParseTape();
+  void Clear();
+
+  // a record of a root. valid only for an accepted tape.
+  size_t GetRoot() const;
+
+  bool IsShift(size_t record) const {
+    return (words[record] & 1) == 0;
+  }
+  int GetSymbol(size_t record) const {
+    return static_cast<int>(words[record] >> 1);
+  }
+  size_t GetOffset(size_t record) const {
+    return words[record + 1];
+  }
+  size_t GetSize(size_t record) const {
+    return words[record + 2];
+  }
+  int GetProduction(size_t record) const {
+    return static_cast<int>(words[record] >> 1);
+  }
+  int GetChildCount(size_t record) const {
+    return static_cast<int>(words[record + 1]);
+  }
+  size_t GetBegin(size_t record) const {
+    return IsShift(record) ? record : record - words[record + 2];
+  }
+
+  // replays a tape into a handler as Parser::ParseAll does. a parser is
+  // loaded with buf which a tape was recorded from and goes through
+  // the same shifts and reductions without lexing.
+  template<typename T>
+  ParseResultType::T Replay(Parser& parser, const byte* buf, size_t size,
+                            const T& handler) const {
+    return ReplayWith<const T>(parser, buf, size, handler);
+  }
+
+  template<typename T>
+  ParseResultType::T Replay(Parser& parser, const byte* buf, size_t size,
+                            T& handler) const {
+    return ReplayWith<T>(parser, buf, size, handler);
+  }
+
+ private:
+  template<typename T>
+  ParseResultType::T ReplayWith(Parser& parser, const byte* buf, size_t size,
+                                T& handler) const {
+    const Grammar& grammar = parser.GetGrammar();
+    parser.LoadBuffer(buf, size);
+
+    // positions are counted again from offsets as a lexer does
+    std::pair<int, int> position = std::make_pair(1, 1);
+    size_t position_offset = 0;
+
+    for (size_t r = 0, r_end = words.size(); r < r_end; r += kRecordSize) {
+      ParseResultType::T ret;
+      if (IsShift(r)) {
+        const Symbol& symbol = grammar.symbols[GetSymbol(r)];
+        size_t offset = GetOffset(r);
+        position = Lexer::AdvancePosition(
+            position, buf + position_offset, offset - position_offset);
+        position_offset = offset;
+        ParserDriver::SetLookahead(
+            parser, Token(&symbol, utf8_substring(buf + offset, GetSize(r)),
+                          position));
+        const LALRAction* a = parser.GetState()->jmp_table[symbol.index];
+        if (a == NULL_PTR || a->type != LALRActionType::kShift) {
+          return ParserDriver::Fail(parser, ParseErrorType::kInternalError);
+        }
+        ret = ParserDriver::Shift(parser, a->target);
+      } else {
+        const Production& p = grammar.productions[GetProduction(r)];
+        const LALRAction* a =
+            parser.GetStateAt(p.handles.size())->jmp_table[p.head];
+        if (a == NULL_PTR || a->type != LALRActionType::kGoto) {
+          return ParserDriver::Fail(parser, ParseErrorType::kInternalError);
+        }
+        ret = ParserDriver::Reduce(parser, p.index, a->target);
+      }
+      if (CPPAUPARSER_HANDLER_WANTS(T, ret)) {
+        handler(ret, parser);
+        if (parser.GetAbortType() != ParseErrorType::kNone) {
+          return ParserDriver::Fail(parser, parser.GetAbortType());
+        }
+      }
+      if (ret == ParseResultType::kError) {
+        return ret;
+      }
+    }
+
+    if (accepted == false) {
+      return ParserDriver::Fail(parser, ParseErrorType::kInternalError);
+    }
+    if (CPPAUPARSER_HANDLER_WANTS(T, ParseResultType::kAccept)) {
+      handler(ParseResultType::kAccept, parser);
+    }
+    return ParseResultType::kAccept;
+  }
+
+ public:
+  std::vector<uint32_t> words;
+  bool accepted;
+};
+
+// TapeBuilder is a ParseAll handler which records a parse into a tape
+// instead of building tree nodes. a parsed text should be given by
+// LoadString or LoadBuffer and Reset with it before parsing.
+// a parse aborts with kLimitExceeded when an offset in a text or
+// an index of a tape doesn't fit in a 32-bit word.
+class CppAuParserDecl TapeBuilder {
+ public:
+  TapeBuilder();
+
+  void Reset(const byte* base);
+  void operator()(ParseResultType::T ret, const Parser& parser);
+
+ public:
+  ParseTape tape;
+
+ private:
+  const byte* base_;
+  // where subtrees of items on a parser stack begin
+  std::vector<uint32_t> begins_;
+};
+
+template<>
+struct ParseHandlerTraits<TapeBuilder> {
+  static const int kEvents =
+      ParseEventMask::kShift | ParseEventMask::kReduce | ParseEventMask::kAccept;
+};
+
+}  // namespace cppauparser
+
+#endif  // _CPPAUPARSER_TAPE_H_
@@ -43,6 +43,9 @@ struct CppAuParserDecl TreeNodeNonTerminal : public TreeNode {
 class CppAuParserDecl TreeNodeAllocator {
  public:
   TreeNodeAllocator();
+  // nodes are taken from a fixed memory and Alloc and Create return
+  // NULL when it is exhausted. Clear doesn't give them back to memory.
+  explicit TreeNodeAllocator(ParseMemory* memory);
   ~TreeNodeAllocator();
 
   TreeNode* Alloc(size_t size);
@@ -50,13 +53,25 @@ class CppAuParserDecl TreeNodeAllocator {
   TreeNodeNonTerminal* Create(const Production* production, int child_count);
 
   void Clear();
+  // drops every node but keeps blocks to be used again.
+  // (large nodes get their own blocks and those are freed)
+  void Reset();
   void Swap(TreeNodeAllocator& a);
+  // takes every node of a. a becomes empty.
+  void Merge(TreeNodeAllocator& a);
+
+  size_t GetUsedBytes() const;
 
  private:
   size_t block_size_;
   std::vector<void*> blocks_;
+  size_t next_block_;
+  // blocks of large nodes and merged ones. not reused.
+  std::vector<void*> large_blocks_;
   void* cur_;
   size_t cur_left_;
+  size_t used_bytes_;
+  ParseMemory* memory_;
 
   CPPAUPARSER_UNCOPYABLE(TreeNodeAllocator);
 };
@@ -64,23 +79,54 @@ class CppAuParserDecl TreeNodeAllocator {
 class CppAuParserDecl TreeBuilder {
  public:
   TreeBuilder();
+  // builds a tree on a fixed memory and aborts a parse with
+  // kOutOfMemory when it runs out.
+  explicit TreeBuilder(ParseMemory* memory);
   void operator()(ParseResultType::T ret, const Parser& parser);
 
+  // drops a result for a next parse keeping memory
+  void Reset();
+
  public:
   TreeNode* result;
   TreeNodeAllocator allocator;
+
+ private:
+  // max_tree_bytes of a parser read at a first event of a parse. 0 when
+  // it's not read yet. it's read again after Reset or an end of a parse.
+  size_t tree_limit_;
+};
+
+template<>
+struct ParseHandlerTraits<TreeBuilder> {
+  static const int kEvents =
+      ParseEventMask::kShift | ParseEventMask::kReduce |
+      ParseEventMask::kAccept | ParseEventMask::kError;
 };
 
 class CppAuParserDecl SimplifiedTreeBuilder {
  public:
   SimplifiedTreeBuilder();
+  // builds a tree and keeps buffers of lists on a fixed memory and aborts
+  // a parse with kOutOfMemory when it runs out. buffers are used again by
+  // a next parse, so make a builder again after a region is reset below
+  // a point where it was made.
+  explicit SimplifiedTreeBuilder(ParseMemory* memory);
+  ~SimplifiedTreeBuilder();
   void operator()(ParseResultType::T ret, const Parser& parser);
 
+  // drops a result for a next parse keeping memory
+  void Reset();
+
  public:
   TreeNode* result;
   TreeNodeAllocator allocator;
 
  private:
+  void CheckTreeLimit(const Parser& parser);
+  void AbortParse(const Parser& parser, ParseErrorType::T error);
+  byte* AllocListBuffer(int max_childs);
+  byte* GrowListBuffer(byte* buf, int child_count, int max_childs);
   void PopListNode();
   TreeNodeNonTerminal* PopListNodeAndMove();
 
@@ -88,15 +134,30 @@ class CppAuParserDecl SimplifiedTreeBuilder {
     const ParseItem* item;
     TreeNode* node;
   };
-  std::vector<ChildCandidate> ccs;
+  std::vector<ChildCandidate, ParseAllocator<ChildCandidate> > ccs;
 
   struct ListNode {
     TreeNodeNonTerminal* node;
     byte* buf;
     int max_childs;
   };
-  std::vector<ListNode> lns;
+  std::vector<ListNode, ParseAllocator<ListNode> > lns;
   TreeNodeNonTerminal* ln_cn;
+  // bytes of buffers in lns. counted for a limit with a tree.
+  size_t ln_bytes;
+  // buffers of popped lists to be used again
+  std::vector<ListNode, ParseAllocator<ListNode> > spare_lns;
+  // see TreeBuilder
+  size_t tree_limit_;
+  ParseMemory* memory_;
+
+  CPPAUPARSER_UNCOPYABLE(SimplifiedTreeBuilder);
+};
+
+template<>
+struct ParseHandlerTraits<SimplifiedTreeBuilder> {
+  static const int kEvents =
+      ParseEventMask::kReduce | ParseEventMask::kAccept | ParseEventMask::kError;
 };
 
 }  // namespace cppauparser
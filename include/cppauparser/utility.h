@@ -5,7 +5,9 @@
 
 #include "base.h"
 #include "grammar.h"
+#include "parser.h"
 #include "tree.h"
+#include <memory>
 
 namespace cppauparser {
 
@@ -36,6 +38,54 @@ CppAuParserDecl ParseToTreeResult ParseBufferToSTree(const Grammar& grammar,
                                                      const byte* buf,
                                                      size_t size);
 
+// ParseSession parses many texts with one parser and builders which keep
+// their memory between parses, so that a parse allocates nothing once
+// they have grown enough. A file is read into a buffer of a session which
+// grows the same way, so a file takes only what fopen takes. A result
+// borrows a given text and nodes of a session and is valid until a next
+// parse. NULL on failure.
+class CppAuParserDecl ParseSession {
+ public:
+  explicit ParseSession(const Grammar& grammar);
+  ~ParseSession();
+
+  TreeNode* ParseFileToTree(const PATHCHAR* file_path);
+  TreeNode* ParseStringToTree(const char* s);
+  TreeNode* ParseBufferToTree(const byte* buf, size_t size);
+  TreeNode* ParseFileToSTree(const PATHCHAR* file_path);
+  TreeNode* ParseStringToSTree(const char* s);
+  TreeNode* ParseBufferToSTree(const byte* buf, size_t size);
+
+  // moves a last result out so that it outlives a next parse.
+  // memory of a session which holds it goes together.
+  ParseToTreeResult TakeResult();
+
+  // a result of a last parse. an error is kNone when a text couldn't
+  // be loaded.
+  TreeNode* GetResult() const;
+  const ParseErrorInfo& GetErrorInfo() const;
+  Parser& GetParser();
+
+ private:
+  void Reset();
+  bool LoadFile(const PATHCHAR* file_path);
+  template<typename T>
+  TreeNode* Parse(T& builder, bool loaded);
+
+ private:
+  Parser parser_;
+  TreeBuilder builder_;
+  SimplifiedTreeBuilder simplified_builder_;
+  TreeNode* result_;
+  TreeNodeAllocator* result_allocator_;
+  // a text of a last file. a taken result takes it with it.
+  byte* file_buf_;
+  size_t file_buf_size_;
+  size_t file_size_;
+  bool file_loaded_;
+
+  CPPAUPARSER_UNCOPYABLE(ParseSession);
+};
 }  // namespace cppauparser
 
 #endif  // _CPPAUPARSER_UTILITY_H_
@@ -0,0 +1,548 @@
+// generated by auparser-tool. do not edit.
+
+#ifndef _JSON_PARSER_H_
+#define _JSON_PARSER_H_
+
+#include <cppauparser/parser.h>
+
+namespace json_parser {
+
+namespace PRT = cppauparser::ParseResultType;
+namespace PET = cppauparser::ParseErrorType;
+typedef cppauparser::ParserDriver Driver;
+
+// whether a loaded grammar has the same tables as this parser
+inline bool Matches(const cppauparser::Grammar& grammar) {
+  return grammar.symbols.size() == 22 &&
+         grammar.productions.size() == 19 &&
+         grammar.lalr_states.size() == 29 &&
+         grammar.lalr_init == 0;
+}
+
+// <Json> ::= <Object>
+inline PRT::T Reduce0(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(1)->index) {
+  case 0: return Driver::Reduce(parser, 0, 4);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Json> ::= <Array>
+inline PRT::T Reduce1(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(1)->index) {
+  case 0: return Driver::Reduce(parser, 1, 4);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Object> ::= { <Members> }
+inline PRT::T Reduce2(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(3)->index) {
+  case 0: return Driver::Reduce(parser, 2, 5);
+  case 1: return Driver::Reduce(parser, 2, 14);
+  case 21: return Driver::Reduce(parser, 2, 14);
+  case 23: return Driver::Reduce(parser, 2, 14);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Object> ::= { }
+inline PRT::T Reduce3(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(2)->index) {
+  case 0: return Driver::Reduce(parser, 3, 5);
+  case 1: return Driver::Reduce(parser, 3, 14);
+  case 21: return Driver::Reduce(parser, 3, 14);
+  case 23: return Driver::Reduce(parser, 3, 14);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Members> ::= <Members> , <Member>
+inline PRT::T Reduce4(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(3)->index) {
+  case 2: return Driver::Reduce(parser, 4, 20);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Members> ::= <Member>
+inline PRT::T Reduce5(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(1)->index) {
+  case 2: return Driver::Reduce(parser, 5, 20);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Member> ::= String : <Value>
+inline PRT::T Reduce6(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(3)->index) {
+  case 2: return Driver::Reduce(parser, 6, 19);
+  case 24: return Driver::Reduce(parser, 6, 28);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Array> ::= [ <Values> ]
+inline PRT::T Reduce7(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(3)->index) {
+  case 0: return Driver::Reduce(parser, 7, 3);
+  case 1: return Driver::Reduce(parser, 7, 13);
+  case 21: return Driver::Reduce(parser, 7, 13);
+  case 23: return Driver::Reduce(parser, 7, 13);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Array> ::= [ ]
+inline PRT::T Reduce8(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(2)->index) {
+  case 0: return Driver::Reduce(parser, 8, 3);
+  case 1: return Driver::Reduce(parser, 8, 13);
+  case 21: return Driver::Reduce(parser, 8, 13);
+  case 23: return Driver::Reduce(parser, 8, 13);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Values> ::= <Values> , <Value>
+inline PRT::T Reduce9(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(3)->index) {
+  case 1: return Driver::Reduce(parser, 9, 16);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Values> ::= <Value>
+inline PRT::T Reduce10(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(1)->index) {
+  case 1: return Driver::Reduce(parser, 10, 16);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Value> ::= <Object>
+inline PRT::T Reduce11(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(1)->index) {
+  case 1: return Driver::Reduce(parser, 11, 15);
+  case 21: return Driver::Reduce(parser, 11, 26);
+  case 23: return Driver::Reduce(parser, 11, 27);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Value> ::= <Array>
+inline PRT::T Reduce12(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(1)->index) {
+  case 1: return Driver::Reduce(parser, 12, 15);
+  case 21: return Driver::Reduce(parser, 12, 26);
+  case 23: return Driver::Reduce(parser, 12, 27);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Value> ::= Integer
+inline PRT::T Reduce13(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(1)->index) {
+  case 1: return Driver::Reduce(parser, 13, 15);
+  case 21: return Driver::Reduce(parser, 13, 26);
+  case 23: return Driver::Reduce(parser, 13, 27);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Value> ::= Float
+inline PRT::T Reduce14(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(1)->index) {
+  case 1: return Driver::Reduce(parser, 14, 15);
+  case 21: return Driver::Reduce(parser, 14, 26);
+  case 23: return Driver::Reduce(parser, 14, 27);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Value> ::= String
+inline PRT::T Reduce15(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(1)->index) {
+  case 1: return Driver::Reduce(parser, 15, 15);
+  case 21: return Driver::Reduce(parser, 15, 26);
+  case 23: return Driver::Reduce(parser, 15, 27);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Value> ::= false
+inline PRT::T Reduce16(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(1)->index) {
+  case 1: return Driver::Reduce(parser, 16, 15);
+  case 21: return Driver::Reduce(parser, 16, 26);
+  case 23: return Driver::Reduce(parser, 16, 27);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Value> ::= null
+inline PRT::T Reduce17(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(1)->index) {
+  case 1: return Driver::Reduce(parser, 17, 15);
+  case 21: return Driver::Reduce(parser, 17, 26);
+  case 23: return Driver::Reduce(parser, 17, 27);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+// <Value> ::= true
+inline PRT::T Reduce18(cppauparser::Parser& parser) {
+  switch (parser.GetStateAt(1)->index) {
+  case 1: return Driver::Reduce(parser, 18, 15);
+  case 21: return Driver::Reduce(parser, 18, 26);
+  case 23: return Driver::Reduce(parser, 18, 27);
+  default: return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+inline PRT::T Step(cppauparser::Parser& parser) {
+  int symbol = Driver::ReadLookaheadSymbol(parser);
+  if (symbol < 0) {
+    return (symbol == -1) ? PRT::kNeedMoreInput : PRT::kError;
+  }
+  switch (parser.GetStateAt(0)->index) {
+  case 0:
+    switch (symbol) {
+    case 5:  // [
+      return Driver::Shift(parser, 1);
+    case 7:  // {
+      return Driver::Shift(parser, 2);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 1:
+    switch (symbol) {
+    case 5:  // [
+      return Driver::Shift(parser, 1);
+    case 7:  // {
+      return Driver::Shift(parser, 2);
+    case 6:  // ]
+      return Driver::Shift(parser, 6);
+    case 9:  // false
+      return Driver::Shift(parser, 7);
+    case 10:  // Float
+      return Driver::Shift(parser, 8);
+    case 11:  // Integer
+      return Driver::Shift(parser, 9);
+    case 12:  // null
+      return Driver::Shift(parser, 10);
+    case 13:  // String
+      return Driver::Shift(parser, 11);
+    case 14:  // true
+      return Driver::Shift(parser, 12);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 2:
+    switch (symbol) {
+    case 8:  // }
+      return Driver::Shift(parser, 17);
+    case 13:  // String
+      return Driver::Shift(parser, 18);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 3:
+    switch (symbol) {
+    case 0:  // (EOF)
+      return Reduce1(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 4:
+    switch (symbol) {
+    case 0:  // (EOF)
+      return PRT::kAccept;
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 5:
+    switch (symbol) {
+    case 0:  // (EOF)
+      return Reduce0(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 6:
+    switch (symbol) {
+    case 0:  // (EOF)
+    case 3:  // ,
+    case 6:  // ]
+    case 8:  // }
+      return Reduce8(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 7:
+    switch (symbol) {
+    case 3:  // ,
+    case 6:  // ]
+    case 8:  // }
+      return Reduce16(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 8:
+    switch (symbol) {
+    case 3:  // ,
+    case 6:  // ]
+    case 8:  // }
+      return Reduce14(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 9:
+    switch (symbol) {
+    case 3:  // ,
+    case 6:  // ]
+    case 8:  // }
+      return Reduce13(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 10:
+    switch (symbol) {
+    case 3:  // ,
+    case 6:  // ]
+    case 8:  // }
+      return Reduce17(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 11:
+    switch (symbol) {
+    case 3:  // ,
+    case 6:  // ]
+    case 8:  // }
+      return Reduce15(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 12:
+    switch (symbol) {
+    case 3:  // ,
+    case 6:  // ]
+    case 8:  // }
+      return Reduce18(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 13:
+    switch (symbol) {
+    case 3:  // ,
+    case 6:  // ]
+    case 8:  // }
+      return Reduce12(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 14:
+    switch (symbol) {
+    case 3:  // ,
+    case 6:  // ]
+    case 8:  // }
+      return Reduce11(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 15:
+    switch (symbol) {
+    case 3:  // ,
+    case 6:  // ]
+      return Reduce10(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 16:
+    switch (symbol) {
+    case 3:  // ,
+      return Driver::Shift(parser, 21);
+    case 6:  // ]
+      return Driver::Shift(parser, 22);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 17:
+    switch (symbol) {
+    case 0:  // (EOF)
+    case 3:  // ,
+    case 6:  // ]
+    case 8:  // }
+      return Reduce3(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 18:
+    switch (symbol) {
+    case 4:  // :
+      return Driver::Shift(parser, 23);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 19:
+    switch (symbol) {
+    case 3:  // ,
+    case 8:  // }
+      return Reduce5(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 20:
+    switch (symbol) {
+    case 3:  // ,
+      return Driver::Shift(parser, 24);
+    case 8:  // }
+      return Driver::Shift(parser, 25);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 21:
+    switch (symbol) {
+    case 5:  // [
+      return Driver::Shift(parser, 1);
+    case 7:  // {
+      return Driver::Shift(parser, 2);
+    case 9:  // false
+      return Driver::Shift(parser, 7);
+    case 10:  // Float
+      return Driver::Shift(parser, 8);
+    case 11:  // Integer
+      return Driver::Shift(parser, 9);
+    case 12:  // null
+      return Driver::Shift(parser, 10);
+    case 13:  // String
+      return Driver::Shift(parser, 11);
+    case 14:  // true
+      return Driver::Shift(parser, 12);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 22:
+    switch (symbol) {
+    case 0:  // (EOF)
+    case 3:  // ,
+    case 6:  // ]
+    case 8:  // }
+      return Reduce7(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 23:
+    switch (symbol) {
+    case 5:  // [
+      return Driver::Shift(parser, 1);
+    case 7:  // {
+      return Driver::Shift(parser, 2);
+    case 9:  // false
+      return Driver::Shift(parser, 7);
+    case 10:  // Float
+      return Driver::Shift(parser, 8);
+    case 11:  // Integer
+      return Driver::Shift(parser, 9);
+    case 12:  // null
+      return Driver::Shift(parser, 10);
+    case 13:  // String
+      return Driver::Shift(parser, 11);
+    case 14:  // true
+      return Driver::Shift(parser, 12);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 24:
+    switch (symbol) {
+    case 13:  // String
+      return Driver::Shift(parser, 18);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 25:
+    switch (symbol) {
+    case 0:  // (EOF)
+    case 3:  // ,
+    case 6:  // ]
+    case 8:  // }
+      return Reduce2(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 26:
+    switch (symbol) {
+    case 3:  // ,
+    case 6:  // ]
+      return Reduce9(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 27:
+    switch (symbol) {
+    case 3:  // ,
+    case 8:  // }
+      return Reduce6(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  case 28:
+    switch (symbol) {
+    case 3:  // ,
+    case 8:  // }
+      return Reduce4(parser);
+    default:
+      return Driver::Fail(parser, PET::kSyntaxError);
+    }
+  default:
+    return Driver::Fail(parser, PET::kInternalError);
+  }
+}
+
+template<typename T>
+PRT::T ParseAll(cppauparser::Parser& parser, const T& handler) {
+  while (true) {
+    PRT::T ret = Step(parser);
+    if (CPPAUPARSER_HANDLER_WANTS(T, ret)) {
+      handler(ret, parser);
+      if (parser.GetAbortType() != PET::kNone) {
+        return Driver::Fail(parser, parser.GetAbortType());
+      }
+    }
+    if (ret == PRT::kAccept || ret == PRT::kError ||
+        ret == PRT::kNeedMoreInput) {
+      return ret;
+    }
+  }
+}
+
+template<typename T>
+PRT::T ParseAll(cppauparser::Parser& parser, T& handler) {
+  while (true) {
+    PRT::T ret = Step(parser);
+    if (CPPAUPARSER_HANDLER_WANTS(T, ret)) {
+      handler(ret, parser);
+      if (parser.GetAbortType() != PET::kNone) {
+        return Driver::Fail(parser, parser.GetAbortType());
+      }
+    }
+    if (ret == PRT::kAccept || ret == PRT::kError ||
+        ret == PRT::kNeedMoreInput) {
+      return ret;
+    }
+  }
+}
+
+inline PRT::T ParseAll(cppauparser::Parser& parser) {
+  while (true) {
+    PRT::T ret = Step(parser);
+    if (ret == PRT::kAccept || ret == PRT::kError ||
+        ret == PRT::kNeedMoreInput) {
+      return ret;
+    }
+  }
+}
+
+}  // namespace json_parser
+
+#endif  // _JSON_PARSER_H_
@@ -0,0 +1,44 @@
+// generated by auparser-tool. do not edit.
+
+#ifndef _OPERATOR_IDS_H_
+#define _OPERATOR_IDS_H_
+
+namespace operator_ids {
+
+namespace SymbolID {
+enum T {
+  kEOF_ = 0,  // (EOF)
+  kError_ = 1,  // (Error)
+  kWhitespace_ = 2,  // (Whitespace)
+  kMinus = 3,  // -
+  kLParen = 4,  // (
+  kRParen = 5,  // )
+  kTimes = 6,  // *
+  kDiv = 7,  // /
+  kPlus = 8,  // +
+  kNum = 9,  // Num
+  kE = 10,  // <E>
+  kM = 11,  // <M>
+  kN = 12,  // <N>
+  kV = 13,  // <V>
+};
+}
+
+namespace ProductionID {
+enum T {
+  kE_E_Plus_M = 0,  // <E> ::= <E> + <M>
+  kE_E_Minus_M = 1,  // <E> ::= <E> - <M>
+  kE_M = 2,  // <E> ::= <M>
+  kM_M_Times_N = 3,  // <M> ::= <M> * <N>
+  kM_M_Div_N = 4,  // <M> ::= <M> / <N>
+  kM_N = 5,  // <M> ::= <N>
+  kN_Minus_V = 6,  // <N> ::= - <V>
+  kN_V = 7,  // <N> ::= <V>
+  kV_Num = 8,  // <V> ::= Num
+  kV_LParen_E_RParen = 9,  // <V> ::= ( <E> )
+};
+}
+
+}  // namespace operator_ids
+
+#endif  // _OPERATOR_IDS_H_
@@ -3,6 +3,17 @@
 #include <cppauparser/all.h>
 #include <stdio.h>
 #include <time.h>
+#include <vector>
+
+// generated by following command:
+//   auparser-tool p -n json_parser data/json.egt > json_parser.h
+#include "json_parser.h"
+
+#if CPPAUPARSER_HAS_CONSTEXPR
+// generated by following command:
+//   auparser-tool t -n json_tables data/json.egt > json_tables.h
+# include "json_tables.h"
+#endif
 
 void test_parse(cppauparser::Grammar& grammar, const PATHCHAR* file_path, int icount) {
   cppauparser::Parser parser(grammar);
@@ -21,6 +32,72 @@ void test_parse(cppauparser::Grammar& grammar, const PATHCHAR* file_path, int ic
   printf("PARSE: %fs\n", double(end_tick - start_tick) / CLOCKS_PER_SEC);
 }
 
+void test_generated(cppauparser::Grammar& grammar, const PATHCHAR* file_path, int icount) {
+  cppauparser::Parser parser(grammar);
+  parser.LoadFile(file_path);
+
+  clock_t start_tick = clock();
+  for (int i=0; i < icount; i++) {
+    parser.ResetCursor();
+    auto ret = json_parser::ParseAll(parser);
+    if (ret != cppauparser::ParseResultType::kAccept) {
+      printf("ERROR: %s\n", parser.GetErrorInfo().GetString().c_str());
+      return;
+    }
+  }
+  clock_t end_tick = clock();
+  printf("GEN:   %fs\n", double(end_tick - start_tick) / CLOCKS_PER_SEC);
+}
+
+void test_validate(cppauparser::Grammar& grammar, const PATHCHAR* file_path, int icount) {
+  FILE* fp = PATHOPEN(file_path, PATHSTR("rb"));
+  fseek(fp, 0, SEEK_END);
+  size_t size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  std::vector<cppauparser::byte> buf(size);
+  fread(&buf[0], size, 1, fp);
+  fclose(fp);
+
+  cppauparser::Parser parser(grammar);
+
+  clock_t start_tick = clock();
+  for (int i=0; i < icount; i++) {
+    if (parser.Validate(&buf[0], size) == false) {
+      printf("ERROR: %s\n", parser.GetErrorInfo().GetString().c_str());
+      return;
+    }
+  }
+  clock_t end_tick = clock();
+  printf("VALID: %fs\n", double(end_tick - start_tick) / CLOCKS_PER_SEC);
+}
+
+#if CPPAUPARSER_HAS_CONSTEXPR
+void test_static(const PATHCHAR* file_path, int icount) {
+  FILE* fp = PATHOPEN(file_path, PATHSTR("rb"));
+  fseek(fp, 0, SEEK_END);
+  size_t size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  std::vector<cppauparser::byte> buf(size);
+  fread(&buf[0], size, 1, fp);
+  fclose(fp);
+
+  json_tables::Parser parser;
+  parser.LoadBuffer(&buf[0], size);
+
+  clock_t start_tick = clock();
+  for (int i=0; i < icount; i++) {
+    parser.ResetCursor();
+    auto ret = parser.ParseAll();
+    if (ret != cppauparser::ParseResultType::kAccept) {
+      printf("ERROR: %s\n", parser.GetErrorInfo().GetString().c_str());
+      return;
+    }
+  }
+  clock_t end_tick = clock();
+  printf("STATIC:%fs\n", double(end_tick - start_tick) / CLOCKS_PER_SEC);
+}
+#endif
+
 void test_tree(cppauparser::Grammar& grammar, const PATHCHAR* file_path, int icount) {
   cppauparser::Parser parser(grammar);
   parser.LoadFile(file_path);
@@ -72,6 +149,11 @@ int main(int argc, char* argv[]) {
   grammar.GetProduction("<Array> ::= [ <Values> ]")->sr_merge_child = true;
 
   test_parse(grammar, PATHSTR("data/json_sample_3.txt"), 100);
+  test_generated(grammar, PATHSTR("data/json_sample_3.txt"), 100);
+  test_validate(grammar, PATHSTR("data/json_sample_3.txt"), 100);
+#if CPPAUPARSER_HAS_CONSTEXPR
+  test_static(PATHSTR("data/json_sample_3.txt"), 100);
+#endif
   test_tree(grammar, PATHSTR("data/json_sample_3.txt"), 100);
   test_stree(grammar, PATHSTR("data/json_sample_3.txt"), 100);
   cppauparser::ParseFileToTree(grammar, PATHSTR("data/json_sample_1.txt")).result->Dump();
@@ -33,6 +33,8 @@ int main(int argc, char* argv[]) {
       case cppauparser::ParseResultType::kError:
         printf("Error\t%s\n", parser.GetErrorInfo().GetString().c_str());
         break;
+      default:
+        break;
       }
     }
   };
@@ -62,6 +64,8 @@ int main(int argc, char* argv[]) {
     case cppauparser::ParseResultType::kError:
       printf("Error\t%s\n", parser.GetErrorInfo().GetString().c_str());
       break;
+    default:
+      break;
     }
   });
   */
@@ -0,0 +1,50 @@
+// Copyright 2012 Esun Kim
+
+#include <cppauparser/all.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// IDs of symbols and productions are generated by following command:
+//   auparser-tool s -H data/operator.egt operator_ids > operator_ids.h
+#include "operator_ids.h"
+
+struct Calculator {
+  int Shift(const cppauparser::Token& token) {
+    if (token.symbol->index == operator_ids::SymbolID::kNum) {
+      return atoi((const char*)token.lexeme.c_str());
+    }
+    return 0;
+  }
+
+  int Reduce(int production, int* c) {
+    switch (production) {
+    case operator_ids::ProductionID::kE_E_Plus_M:         return c[0] + c[2];
+    case operator_ids::ProductionID::kE_E_Minus_M:        return c[0] - c[2];
+    case operator_ids::ProductionID::kM_M_Times_N:        return c[0] * c[2];
+    case operator_ids::ProductionID::kM_M_Div_N:          return c[0] / c[2];
+    case operator_ids::ProductionID::kN_Minus_V:          return -c[1];
+    case operator_ids::ProductionID::kV_LParen_E_RParen:  return c[1];
+    default:                                              return c[0];
+    }
+  }
+};
+
+int main(int argc, char* argv[]) {
+  // load grammar
+
+  cppauparser::Grammar grammar;
+  if (grammar.LoadFile(PATHSTR("data/operator.egt")) == false) {
+    printf("fail to open a grammar file\n");
+    return 1;
+  }
+
+  // parse a string with a typed handler
+
+  cppauparser::TypedProductionHandler<int, Calculator> th;
+  cppauparser::Parser parser(grammar);
+  parser.LoadString("-2*(3+4)-5");
+  parser.ParseAll(th);
+  printf("Result = %d\n", th.GetResult());
+
+  return 0;
+}
@@ -0,0 +1,314 @@
+// Copyright 2012 Esun Kim
+
+#include "batch.h"
+#include <algorithm>
+
+namespace cppauparser {
+
+BatchParser::BatchParser(const Grammar& grammar, size_t thread_count)
+    : grammar_(grammar),
+      simplified_(false),
+      chunk_size_(0),
+      ordered_(false),
+      stop_(false) {
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (size_t i = 0; i < thread_count; i++) {
+    sessions_.push_back(
+        std::unique_ptr<ParseSession>(new ParseSession(grammar)));
+  }
+  for (size_t i = 0; i < thread_count; i++) {
+    threads_.push_back(std::thread(&BatchParser::RunWorker, this, i));
+  }
+}
+
+BatchParser::~BatchParser() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  for (auto i = threads_.begin(), i_end = threads_.end(); i != i_end; ++i) {
+    i->join();
+  }
+}
+
+void BatchParser::SetSimplified(bool simplified) {
+  simplified_ = simplified;
+}
+
+void BatchParser::SetChunkSize(size_t size) {
+  chunk_size_ = size;
+}
+
+void BatchParser::SetOrdered(bool ordered) {
+  ordered_ = ordered;
+}
+
+void BatchParser::SetLimits(const ParseLimits& limits) {
+  limits_ = limits;
+  for (auto i = sessions_.begin(), i_end = sessions_.end(); i != i_end; ++i) {
+    (*i)->GetParser().SetLimits(limits);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto i = spare_sessions_.begin(), i_end = spare_sessions_.end();
+       i != i_end; ++i) {
+    (*i)->GetParser().SetLimits(limits);
+  }
+}
+
+size_t BatchParser::GetThreadCount() const {
+  return threads_.size();
+}
+
+std::vector<std::future<ParseToTreeResult> > BatchParser::ParseBuffersAsync(
+    const utf8_substring* texts, size_t count) {
+  return RunAsync(count, BufferParse(texts));
+}
+
+std::vector<std::future<ParseToTreeResult> > BatchParser::ParseFilesAsync(
+    const PATHCHAR* const* file_paths, size_t count) {
+  return RunAsync(count, FileParse(file_paths));
+}
+
+BatchParser::Job BatchParser::BufferParse(
+    const utf8_substring* texts) const {
+  if (simplified_) {
+    return [texts](ParseSession& session, size_t i) {
+      session.ParseBufferToSTree(texts[i].c_str(), texts[i].size());
+    };
+  } else {
+    return [texts](ParseSession& session, size_t i) {
+      session.ParseBufferToTree(texts[i].c_str(), texts[i].size());
+    };
+  }
+}
+
+BatchParser::Job BatchParser::FileParse(
+    const PATHCHAR* const* file_paths) const {
+  if (simplified_) {
+    return [file_paths](ParseSession& session, size_t i) {
+      session.ParseFileToSTree(file_paths[i]);
+    };
+  } else {
+    return [file_paths](ParseSession& session, size_t i) {
+      session.ParseFileToTree(file_paths[i]);
+    };
+  }
+}
+
+std::vector<std::future<ParseToTreeResult> > BatchParser::RunAsync(
+    size_t count, const Job& parse) {
+  std::shared_ptr<std::vector<std::promise<ParseToTreeResult> > > promises =
+      std::make_shared<std::vector<std::promise<ParseToTreeResult> > >(
+          count);
+  std::vector<std::future<ParseToTreeResult> > futures;
+  futures.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    futures.push_back((*promises)[i].get_future());
+  }
+  Run(count, parse, [promises](ParseSession& session, size_t i) {
+    (*promises)[i].set_value(session.TakeResult());
+  }, false);
+  return futures;
+}
+
+void BatchParser::Run(size_t count, const Job& parse, const Job& deliver,
+                      bool wait) {
+  if (count == 0) {
+    return;
+  }
+
+  std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+  size_t thread_count = threads_.size();
+  batch->parse = parse;
+  batch->deliver = deliver;
+  batch->ordered = wait && ordered_;
+  // an ordered batch takes one text at once by default so that few
+  // results wait for their turn
+  batch->chunk = chunk_size_ ? chunk_size_
+      : batch->ordered ? 1
+      : std::min(std::max(count / (thread_count * 16), size_t(1)),
+                 size_t(64));
+  batch->ranges.reset(new Range[thread_count]);
+  for (size_t i = 0; i < thread_count; i++) {
+    batch->ranges[i].begin = count * i / thread_count;
+    batch->ranges[i].end = count * (i + 1) / thread_count;
+  }
+  batch->left = count;
+  batch->taken = 0;
+  batch->next = 0;
+  if (batch->ordered) {
+    batch->parked.resize(count);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batches_.push_back(batch);
+  }
+  cond_.notify_all();
+
+  if (wait) {
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    while (batch->left != 0) {
+      batch->cond.wait(lock);
+    }
+  }
+}
+
+void BatchParser::RunWorker(size_t index) {
+  while (true) {
+    std::shared_ptr<Batch> batch;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (stop_ == false && batches_.empty()) {
+        cond_.wait(lock);
+      }
+      if (batches_.empty()) {
+        return;
+      }
+      batch = batches_.front();
+    }
+
+    size_t begin;
+    size_t end;
+    while (Take(batch.get(), index, &begin, &end)) {
+      for (size_t i = begin; i < end; i++) {
+        // a session of a worker changes when its result is parked
+        ParseSession& session = *sessions_[index];
+        batch->parse(session, i);
+        if (batch->ordered) {
+          DeliverOrdered(batch.get(), index, i);
+          continue;
+        }
+        batch->deliver(session, i);
+        if (--batch->left == 0) {
+          std::lock_guard<std::mutex> lock(batch->mutex);
+          batch->cond.notify_all();
+        }
+      }
+    }
+
+    // nothing to take. a batch leaves a queue while others finish it.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (batches_.empty() == false && batches_.front() == batch) {
+      batches_.pop_front();
+    }
+  }
+}
+
+bool BatchParser::Take(Batch* batch, size_t index, size_t* begin,
+                       size_t* end) {
+  if (batch->ordered) {
+    size_t count = batch->parked.size();
+    *begin = batch->taken.fetch_add(batch->chunk);
+    if (*begin >= count) {
+      return false;
+    }
+    *end = std::min(*begin + batch->chunk, count);
+    return true;
+  }
+
+  size_t thread_count = threads_.size();
+  Range& own = batch->ranges[index];
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (own.begin < own.end) {
+        *begin = own.begin;
+        *end = std::min(own.begin + batch->chunk, own.end);
+        own.begin = *end;
+        return true;
+      }
+    }
+
+    // steal a back half of a longest range
+    size_t victim = thread_count;
+    size_t longest = 0;
+    for (size_t i = 0; i < thread_count; i++) {
+      Range& r = batch->ranges[i];
+      std::lock_guard<std::mutex> lock(r.mutex);
+      if (r.end - r.begin > longest) {
+        longest = r.end - r.begin;
+        victim = i;
+      }
+    }
+    if (victim == thread_count) {
+      return false;
+    }
+    size_t stolen_begin;
+    size_t stolen_end;
+    {
+      Range& r = batch->ranges[victim];
+      std::lock_guard<std::mutex> lock(r.mutex);
+      if (r.begin == r.end) {
+        continue;
+      }
+      stolen_end = r.end;
+      stolen_begin = r.begin + (r.end - r.begin) / 2;
+      r.end = stolen_begin;
+    }
+    std::lock_guard<std::mutex> lock(own.mutex);
+    own.begin = stolen_begin;
+    own.end = stolen_end;
+  }
+}
+
+// a worker which parsed a next text delivers it and results parked after
+// it. others park a result with a session and go on with a spare one, so
+// that no worker waits for its turn.
+void BatchParser::DeliverOrdered(Batch* batch, size_t index, size_t i) {
+  std::unique_ptr<ParseSession>& own = sessions_[index];
+  {
+    std::lock_guard<std::mutex> lock(batch->mutex);
+    if (batch->next != i) {
+      batch->parked[i] = std::move(own);
+    }
+  }
+  if (own == NULL_PTR) {
+    own = TakeSpareSession();
+    return;
+  }
+
+  batch->deliver(*own, i);
+  while (true) {
+    std::unique_ptr<ParseSession> session;
+    {
+      std::lock_guard<std::mutex> lock(batch->mutex);
+      batch->next += 1;
+      if (--batch->left == 0) {
+        batch->cond.notify_all();
+      }
+      if (batch->next == batch->parked.size() ||
+          batch->parked[batch->next] == NULL_PTR) {
+        return;
+      }
+      session = std::move(batch->parked[batch->next]);
+      i = batch->next;
+    }
+    batch->deliver(*session, i);
+    // a slow text may park many results. a few sessions are kept for them
+    // and others are freed.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (spare_sessions_.size() < threads_.size()) {
+      spare_sessions_.push_back(std::move(session));
+    }
+  }
+}
+
+std::unique_ptr<ParseSession> BatchParser::TakeSpareSession() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (spare_sessions_.empty() == false) {
+      std::unique_ptr<ParseSession> session = std::move(spare_sessions_.back());
+      spare_sessions_.pop_back();
+      return session;
+    }
+  }
+  std::unique_ptr<ParseSession> session(new ParseSession(grammar_));
+  session->GetParser().SetLimits(limits_);
+  return session;
+}
+
+}  // namespace cppauparser
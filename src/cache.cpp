@@ -0,0 +1,191 @@
+// Copyright 2012 Esun Kim
+
+#include "cache.h"
+#include "lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+namespace cppauparser {
+
+ParseCache::ParseCache(size_t max_bytes, size_t shard_count)
+    : shard_count_(std::max(shard_count, size_t(1))),
+      hit_count_(0),
+      miss_count_(0) {
+  shard_bytes_ = max_bytes / shard_count_;
+  shards_.reset(new Shard[shard_count_]);
+  for (size_t i = 0; i < shard_count_; i++) {
+    shards_[i].used_bytes = 0;
+  }
+}
+
+ParseCache::~ParseCache() {
+}
+
+ParseToTreeResult ParseCache::ParseFileToTree(const Grammar& grammar,
+                                              const PATHCHAR* file_path) {
+  return ParseFile(grammar, file_path, false);
+}
+
+ParseToTreeResult ParseCache::ParseStringToTree(const Grammar& grammar,
+                                                const char* s) {
+  return Parse(grammar, reinterpret_cast<const byte*>(s), strlen(s),
+               NULL_PTR, false);
+}
+
+ParseToTreeResult ParseCache::ParseBufferToTree(const Grammar& grammar,
+                                                const byte* buf,
+                                                size_t size) {
+  return Parse(grammar, buf, size, NULL_PTR, false);
+}
+
+ParseToTreeResult ParseCache::ParseFileToSTree(const Grammar& grammar,
+                                               const PATHCHAR* file_path) {
+  return ParseFile(grammar, file_path, true);
+}
+
+ParseToTreeResult ParseCache::ParseStringToSTree(const Grammar& grammar,
+                                                 const char* s) {
+  return Parse(grammar, reinterpret_cast<const byte*>(s), strlen(s),
+               NULL_PTR, true);
+}
+
+ParseToTreeResult ParseCache::ParseBufferToSTree(const Grammar& grammar,
+                                                 const byte* buf,
+                                                 size_t size) {
+  return Parse(grammar, buf, size, NULL_PTR, true);
+}
+
+void ParseCache::Clear() {
+  for (size_t i = 0; i < shard_count_; i++) {
+    Shard& shard = shards_[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.index.clear();
+    shard.entries.clear();
+    shard.used_bytes = 0;
+  }
+}
+
+size_t ParseCache::GetUsedBytes() const {
+  size_t bytes = 0;
+  for (size_t i = 0; i < shard_count_; i++) {
+    Shard& shard = shards_[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    bytes += shard.used_bytes;
+  }
+  return bytes;
+}
+
+size_t ParseCache::GetEntryCount() const {
+  size_t count = 0;
+  for (size_t i = 0; i < shard_count_; i++) {
+    Shard& shard = shards_[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    count += shard.index.size();
+  }
+  return count;
+}
+
+size_t ParseCache::GetHitCount() const {
+  return hit_count_;
+}
+
+size_t ParseCache::GetMissCount() const {
+  return miss_count_;
+}
+
+ParseToTreeResult ParseCache::Parse(const Grammar& grammar, const byte* buf,
+                                    size_t size, byte* owned,
+                                    bool simplified) {
+  Key key;
+  key.text = HashBytes(buf, size);
+  key.grammar = &grammar;
+  key.fingerprint = grammar.GetFingerprint();
+  key.size = size;
+  key.simplified = simplified;
+  Shard& shard = shards_[(key.text.high ^ key.fingerprint.high) % shard_count_];
+
+  ParseToTreeResult kept;
+  const byte* kept_text = NULL_PTR;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto i = shard.index.find(key);
+    if (i != shard.index.end()) {
+      shard.entries.splice(shard.entries.begin(), shard.entries, i->second);
+      kept = i->second->result;
+      kept_text = i->second->text;
+    }
+  }
+  // a kept result holds its text, so it's compared out of a lock
+  if (kept_text != NULL_PTR && memcmp(kept_text, buf, size) == 0) {
+    hit_count_ += 1;
+    free(owned);
+    return kept;
+  }
+  miss_count_ += 1;
+
+  // a kept tree refers to a text which a cache should own
+  if (owned == NULL_PTR) {
+    owned = reinterpret_cast<byte*>(malloc(std::max(size, size_t(1))));
+    memcpy(owned, buf, size);
+  }
+  std::shared_ptr<LexerBuffer> text = std::make_shared<LexerBuffer>();
+  text->SetBuffer(owned, size, false);
+
+  ParseToTreeResult ret = simplified
+      ? cppauparser::ParseBufferToSTree(grammar, owned, size)
+      : cppauparser::ParseBufferToTree(grammar, owned, size);
+  // a token of an error info also refers to a text
+  ret.lexer_buffer = text;
+  if (ret.result == NULL_PTR) {
+    return ret;
+  }
+
+  if (kept_text != NULL_PTR) {
+    // a collision. a key is taken by another text.
+    return ret;
+  }
+
+  Entry entry = { key, ret, owned, 0 };
+  entry.bytes = sizeof(Entry) + size + ret.node_allocator->GetUsedBytes();
+  if (entry.bytes > shard_bytes_) {
+    return ret;
+  }
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (shard.index.find(key) != shard.index.end()) {
+    // parsed by another thread at the same time
+    return ret;
+  }
+  shard.entries.push_front(entry);
+  shard.index[key] = shard.entries.begin();
+  shard.used_bytes += entry.bytes;
+  while (shard.used_bytes > shard_bytes_) {
+    const Entry& last = shard.entries.back();
+    shard.used_bytes -= last.bytes;
+    shard.index.erase(last.key);
+    shard.entries.pop_back();
+  }
+  return ret;
+}
+
+ParseToTreeResult ParseCache::ParseFile(const Grammar& grammar,
+                                        const PATHCHAR* file_path,
+                                        bool simplified) {
+  FILE* fp = PATHOPEN(file_path, PATHSTR("rb"));
+  if (fp == NULL) {
+    return ParseToTreeResult();
+  }
+
+  fseek(fp, 0, SEEK_END);
+  size_t size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  byte* buf = reinterpret_cast<byte*>(malloc(std::max(size, size_t(1))));
+  size_t read = fread(buf, 1, size, fp);
+  fclose(fp);
+
+  return Parse(grammar, buf, read, buf, simplified);
+}
+
+}  // namespace cppauparser
@@ -0,0 +1,132 @@
+// Copyright 2012 Esun Kim
+
+#include "extract.h"
+#include <string.h>
+
+namespace cppauparser {
+
+ColumnExtractor::ColumnExtractor(const Grammar& grammar)
+    : grammar_(grammar),
+      base_(NULL_PTR),
+      symbol_columns_(grammar.symbols.size(), -1),
+      production_columns_(grammar.productions.size(), -1),
+      track_spans_(false) {
+}
+
+int ColumnExtractor::AddColumn(const char* symbol_id) {
+  const Symbol* symbol = grammar_.GetSymbol(symbol_id);
+  if (symbol == NULL_PTR || symbol->type == SymbolType::kNonTerminal) {
+    return -1;
+  }
+  return AddColumn(&symbol_columns_, symbol->index, -1, -1, NULL_PTR);
+}
+
+int ColumnExtractor::AddColumn(const char* production_id, int handle) {
+  return AddColumn(production_id, handle, -1, NULL_PTR);
+}
+
+int ColumnExtractor::AddColumn(const char* production_id, int handle,
+                               int key_handle, const char* key) {
+  const Production* production = grammar_.GetProduction(production_id);
+  int handle_count = production
+      ? static_cast<int>(production->handles.size()) : 0;
+  if (handle < 0 || handle >= handle_count ||
+      key_handle >= handle_count || (key && key_handle < 0)) {
+    return -1;
+  }
+  track_spans_ = true;
+  return AddColumn(&production_columns_, production->index, handle,
+                   key_handle, key);
+}
+
+int ColumnExtractor::AddColumn(std::vector<int>* heads, int index,
+                               int handle, int key_handle, const char* key) {
+  Column c;
+  c.handle = handle;
+  c.key_handle = (key != NULL_PTR) ? key_handle : -1;
+  if (key != NULL_PTR) {
+    c.key = reinterpret_cast<const byte*>(key);
+  }
+  c.next = (*heads)[index];
+  (*heads)[index] = static_cast<int>(columns_.size());
+  columns_.push_back(c);
+  return static_cast<int>(columns_.size() - 1);
+}
+
+void ColumnExtractor::Reset(const byte* base) {
+  base_ = base;
+  for (auto i = columns_.begin(), i_end = columns_.end(); i != i_end; ++i) {
+    i->data.offsets.clear();
+    i->data.sizes.clear();
+  }
+  spans_.clear();
+  // a bottom item of a parser stack
+  Span bottom = { 0, 0 };
+  spans_.push_back(bottom);
+}
+
+void ColumnExtractor::operator()(ParseResultType::T ret,
+                                 const Parser& parser) {
+  if (ret == ParseResultType::kShift) {
+    const Token& token = parser.GetToken();
+    size_t offset = GetOffset(token);
+    for (int c = symbol_columns_[token.symbol->index]; c != -1;
+         c = columns_[c].next) {
+      columns_[c].data.offsets.push_back(offset);
+      columns_[c].data.sizes.push_back(token.lexeme.size());
+    }
+    if (track_spans_) {
+      Span span = { offset, offset + token.lexeme.size() };
+      spans_.push_back(span);
+    }
+  } else if (ret == ParseResultType::kReduce) {
+    if (track_spans_ == false) {
+      return;
+    }
+
+    const ParseReduction& r = parser.GetReduction();
+    size_t n = r.handles->size();
+    const Span* hs = spans_.data() + (spans_.size() - n);
+    for (int c = production_columns_[r.production->index]; c != -1;
+         c = columns_[c].next) {
+      const Column& column = columns_[c];
+      if (column.key_handle != -1) {
+        const Span& k = hs[column.key_handle];
+        if (k.end - k.offset != column.key.size() ||
+            memcmp(base_ + k.offset, column.key.c_str(),
+                   column.key.size()) != 0) {
+          continue;
+        }
+      }
+      const Span& h = hs[column.handle];
+      columns_[c].data.offsets.push_back(h.offset);
+      columns_[c].data.sizes.push_back(h.end - h.offset);
+    }
+
+    // an empty production takes a place where a previous item ends
+    Span span;
+    if (n > 0) {
+      span.offset = hs[0].offset;
+      span.end = hs[n - 1].end;
+    } else {
+      span.offset = span.end = spans_.back().end;
+    }
+    spans_.resize(spans_.size() - n);
+    spans_.push_back(span);
+  }
+}
+
+const ExtractColumn& ColumnExtractor::GetColumn(int column) const {
+  return columns_[column].data;
+}
+
+utf8_substring ColumnExtractor::GetText(int column, size_t i) const {
+  const ExtractColumn& c = columns_[column].data;
+  return utf8_substring(base_ + c.offsets[i], c.sizes[i]);
+}
+
+size_t ColumnExtractor::GetOffset(const Token& token) const {
+  return token.lexeme.c_str() - base_;
+}
+
+}  // namespace cppauparser
@@ -5,34 +5,60 @@
 #include <string.h>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 
 namespace cppauparser {
 
+struct Grammar::StateCounters {
+  // whether a lookup of a state is built. NULL when all are.
+  std::unique_ptr<std::atomic<bool>[]> dfa_built;
+  std::unique_ptr<std::atomic<bool>[]> lalr_built;
+  std::mutex lookup_mutex;
+  // visits of states. NULL without profiling.
+  std::unique_ptr<std::atomic<uint64_t>[]> dfa_visits;
+  std::unique_ptr<std::atomic<uint64_t>[]> lalr_visits;
+};
+
 utf8_string Symbol::GetID() const {
-  if (type == SymbolType::kNonTerminal) {
-    return utf8_format("<%s>", name.c_str());
-  } else if (type == SymbolType::kTerminal) {
-    return utf8_format("%s", name.c_str());
-  } else {
-    return utf8_format("(%s)", name.c_str());
+  if (type == SymbolType::kTerminal) {
+    return name;
   }
+  bool nonterminal = (type == SymbolType::kNonTerminal);
+  utf8_string ret;
+  ret.reserve(name.size() + 2);
+  ret += nonterminal ? '<' : '(';
+  ret += name;
+  ret += nonterminal ? '>' : ')';
+  return ret;
 }
 
 utf8_string Production::GetID() const {
-  utf8_string ret = head_ref->GetID() + (const byte*)" ::= ";
+  utf8_string ret = head_ref->GetID();
+  ret += (const byte*)" ::= ";
   for (auto i = handle_refs.cbegin(),
             i_end = handle_refs.cend();
        i != i_end; ++i) {
-    if (i == handle_refs.begin()) {
-      ret += (*i)->GetID();
-    } else {
-      ret += (const byte*)" " + (*i)->GetID();
+    if (i != handle_refs.begin()) {
+      ret += ' ';
     }
+    ret += (*i)->GetID();
   }
   return ret;
 }
 
-Grammar::Grammar() {
+Grammar::Grammar()
+    : lazy_lookup_(false),
+      minimize_(false),
+      profiling_(false),
+      counters_(new StateCounters),
+      dfa_direct_(true),
+      lalr_direct_(true),
+      layout_applied_(false) {
+  memset(&minimize_stats_, 0, sizeof(minimize_stats_));
+}
+
+Grammar::~Grammar() {
 }
 
 bool Grammar::LoadFile(const PATHCHAR* file_path) {
@@ -54,176 +80,365 @@ bool Grammar::LoadFile(const PATHCHAR* file_path) {
   return ret;
 }
 
-inline byte read_byte(const char** buf) {
-  byte v = **buf;
-  *buf += 1;
-  return v;
-}
-
-inline bool read_bool(const char** buf) {
-  bool v = (**buf == 1);
-  *buf += 1;
-  return v;
-}
-
 inline int16_t read_integer(const char** buf) {
   int16_t v = *reinterpret_cast<const int16_t*>(*buf);
   *buf += 2;
   return v;
 }
 
-inline utf8_string read_string(const char** buf) {
-  utf8_string ret;
-  const uint16_t* ra = convert_utf16_to_utf8_string(
-      reinterpret_cast<const uint16_t*>(*buf),
-      &ret);
-  *buf = reinterpret_cast<const char*>(ra);
-  return ret;
+// returns an end of a null terminated utf16 string or NULL out of a buffer
+inline const char* skip_string(const char* buf, const char* buf_end) {
+  for (; buf_end - buf >= 2; buf += 2) {
+    if (buf[0] == 0 && buf[1] == 0) {
+      return buf + 2;
+    }
+  }
+  return NULL_PTR;
 }
 
+// a value of an entry. a string is kept as a position in a buffer and
+// decoded only into a place where it's used.
 struct EntryValue {
   char type;
-  bool v_bool;
-  byte v_byte;
-  int16_t v_int;
-  utf8_string v_str;
+  int16_t v_int;  // a byte, a bool or an integer
+  const char* v_str;
+};
+
+// a record of entries which are values[begin, begin + count)
+struct EntryRecord {
+  size_t begin;
+  int count;
 };
 
-inline bool read_value(const char** buf, EntryValue* value) {
-  switch (**buf) {
+inline bool read_value(const char** buf, const char* buf_end,
+                       EntryValue* value) {
+  if (*buf >= buf_end) {
+    return false;
+  }
+  value->type = *((*buf)++);
+  value->v_int = 0;
+  value->v_str = NULL_PTR;
+  switch (value->type) {
   case 'E':
-    value->type = *((*buf)++);
     break;
   case 'b':
-    value->type = *((*buf)++);
-    value->v_byte = read_byte(buf);
+    if (buf_end - *buf < 1) {
+      return false;
+    }
+    value->v_int = static_cast<byte>(*((*buf)++));
     break;
   case 'B':
-    value->type = *((*buf)++);
-    value->v_bool = read_bool(buf);
+    if (buf_end - *buf < 1) {
+      return false;
+    }
+    value->v_int = (*((*buf)++) == 1);
     break;
   case 'I':
-    value->type = *((*buf)++);
+    if (buf_end - *buf < 2) {
+      return false;
+    }
     value->v_int = read_integer(buf);
     break;
   case 'S':
-    value->type = *((*buf)++);
-    value->v_str = read_string(buf);
+    value->v_str = *buf;
+    *buf = skip_string(*buf, buf_end);
+    if (*buf == NULL_PTR) {
+      return false;
+    }
     break;
   default:
-    value->type = 0;
     return false;
   }
+  return true;
+}
 
+// returns false when a value is not a string
+inline bool read_string(const EntryValue& value, utf8_string* s) {
+  if (value.v_str == NULL_PTR) {
+    return false;
+  }
+  convert_utf16_to_utf8_string(
+      reinterpret_cast<const uint16_t*>(value.v_str), s);
   return true;
 }
 
+// whether a value is an index of a table of a size
+inline bool in_table(int value, size_t size) {
+  return value >= 0 && size_t(value) < size;
+}
+
+// a slot of a table for a record of an index or NULL when an index is out
+// of a table or a slot is filled already. slots not filled have -1.
+template<typename T>
+inline T* take_slot(std::vector<T>* table, int index) {
+  if (in_table(index, table->size()) == false ||
+      (*table)[index].index != -1) {
+    return NULL_PTR;
+  }
+  T* slot = &(*table)[index];
+  slot->index = index;
+  return slot;
+}
+
+template<typename T>
+inline void clear_slots(std::vector<T>* table, size_t size) {
+  table->clear();
+  table->resize(size);
+  for (size_t i = 0; i < size; i++) {
+    (*table)[i].index = -1;
+  }
+}
+
 bool Grammar::LoadBuffer(const char* buf, size_t len) {
   const char* buf_end = buf + len;
+  fingerprint_ = HashBytes(buf, len);
 
-  utf8_string header = read_string(&buf);
+  EntryValue header_value;
+  header_value.v_str = buf;
+  buf = skip_string(buf, buf_end);
+  if (buf == NULL_PTR) {
+    return false;
+  }
+  utf8_string header;
+  read_string(header_value, &header);
   if (strcmp((const char*)header.c_str(), "GOLD Parser Tables/v5.0") != 0) {
     return false;
   }
 
+  // 1st pass: scan every record into one array of values and count them
+  // so that tables are filled with exact sizes and no allocation per value.
+
   std::vector<EntryValue> v;
-  while (buf < buf_end && read_byte(&buf) == 'M') {
-    // read entries
-    int16_t value_count = read_integer(&buf);
-    if (v.size() < (size_t)value_count) {
-      v.resize((size_t)value_count);
+  std::vector<EntryRecord> records;
+  v.reserve(len / 3);
+  size_t property_count = 0;
+  while (buf < buf_end && *buf == 'M') {
+    buf += 1;
+    if (buf_end - buf < 2) {
+      return false;
+    }
+    EntryRecord record;
+    record.begin = v.size();
+    record.count = read_integer(&buf);
+    if (record.count < 1) {
+      return false;
     }
-    for (int i = 0; i < value_count; i++) {
-      if (read_value(&buf, &v[i]) == false) {
+    v.resize(v.size() + record.count);
+    for (int i = 0; i < record.count; i++) {
+      if (read_value(&buf, buf_end, &v[record.begin + i]) == false) {
         return false;
       }
     }
+    if (v[record.begin].v_int == 'p') {
+      property_count += 1;
+    }
+    records.push_back(record);
+  }
 
-    // set by entries
-    switch (v[0].v_byte) {
+  // 2nd pass: fill tables. an index out of a table, a slot filled twice
+  // or a record shorter than its counts fails a load. so does a reference
+  // to another table out of it. a table record comes before others.
+  //
+  // vectors are reserved at exact sizes but actions of a LALR state are
+  // still a map of nodes allocated one by one, so a load takes allocations
+  // growing with actions. (LALRState::actions is a public type)
+
+  // tables are filled from scratch. (a grammar can be loaded again)
+  properties.clear();
+  properties.reserve(property_count);
+  clear_slots(&symbols, 0);
+  clear_slots(&charsets, 0);
+  clear_slots(&productions, 0);
+  clear_slots(&dfa_states, 0);
+  clear_slots(&lalr_states, 0);
+  clear_slots(&symbol_groups, 0);
+  bool sized = false;
+  size_t filled = 0;
+  dfa_init = -1;
+  lalr_init = -1;
+  for (auto r = records.begin(), r_end = records.end(); r != r_end; ++r) {
+    const EntryValue* e = &v[r->begin];
+    const int count = r->count;
+    const int index = (count > 1) ? e[1].v_int : -1;
+
+    switch (e[0].v_int) {
     case 'p': {
-        Property o;
-        o.index = v[1].v_int;
-        o.name = v[2].v_str;
-        o.value = v[3].v_str;
-        properties.push_back(o);
+        if (count < 4) {
+          return false;
+        }
+        properties.push_back(Property());
+        Property& o = properties.back();
+        o.index = index;
+        if (read_string(e[2], &o.name) == false ||
+            read_string(e[3], &o.value) == false) {
+          return false;
+        }
       }
       break;
     case 't': {
-        symbols.resize(v[1].v_int);
-        charsets.resize(v[2].v_int);
-        productions.resize(v[3].v_int);
-        dfa_states.resize(v[4].v_int);
-        lalr_states.resize(v[5].v_int);
-        symbol_groups.resize(v[6].v_int);
+        if (count < 7 || sized) {
+          return false;
+        }
+        for (int i = 1; i < 7; i++) {
+          if (e[i].v_int < 0) {
+            return false;
+          }
+        }
+        sized = true;
+        clear_slots(&symbols, e[1].v_int);
+        clear_slots(&charsets, e[2].v_int);
+        clear_slots(&productions, e[3].v_int);
+        clear_slots(&dfa_states, e[4].v_int);
+        clear_slots(&lalr_states, e[5].v_int);
+        clear_slots(&symbol_groups, e[6].v_int);
       }
       break;
     case 'c': {
-        CharacterSet& o = charsets[v[1].v_int];
-        o.index = v[1].v_int;
-        o.uniplane = v[2].v_int;
-        for (int16_t i = 0; i < v[3].v_int; i++) {
+        CharacterSet* slot = take_slot(&charsets, index);
+        if (slot == NULL_PTR || count < 5 || e[3].v_int < 0 ||
+            count < 5 + e[3].v_int * 2) {
+          return false;
+        }
+        filled += 1;
+        CharacterSet& o = *slot;
+        o.uniplane = e[2].v_int;
+        o.ranges.reserve(e[3].v_int);
+        for (int16_t i = 0; i < e[3].v_int; i++) {
           o.ranges.push_back(std::make_pair(
-            (uint16_t)v[5+i*2].v_int,
-            (uint16_t)v[6+i*2].v_int));
+            (uint16_t)e[5+i*2].v_int,
+            (uint16_t)e[6+i*2].v_int));
         }
       }
       break;
     case 'S': {
-        Symbol& o = symbols[v[1].v_int];
-        o.index = v[1].v_int;
-        o.name = v[2].v_str;
-        o.type = (SymbolType::T)v[3].v_int;
+        Symbol* slot = take_slot(&symbols, index);
+        if (slot == NULL_PTR || count < 4 ||
+            e[3].v_int < SymbolType::kNonTerminal ||
+            e[3].v_int > SymbolType::kError) {
+          return false;
+        }
+        filled += 1;
+        Symbol& o = *slot;
+        if (read_string(e[2], &o.name) == false) {
+          return false;
+        }
+        o.type = (SymbolType::T)e[3].v_int;
       }
       break;
     case 'g': {
-        SymbolGroup& o = symbol_groups[v[1].v_int];
-        o.index = v[1].v_int;
-        o.name = v[2].v_str;
-        o.container = v[3].v_int;
-        o.start = v[4].v_int;
-        o.end = v[5].v_int;
-        o.advance_mode = (AdvanceModeType::T)v[6].v_int;
-        o.ending_mode = (EndingModeType::T)v[7].v_int;
-        for (int16_t i = 0; i < v[9].v_int; i++) {
-          o.nesting_groups.push_back(v[10+i].v_int);
+        SymbolGroup* slot = take_slot(&symbol_groups, index);
+        if (slot == NULL_PTR || count < 10 || e[9].v_int < 0 ||
+            count < 10 + e[9].v_int ||
+            in_table(e[3].v_int, symbols.size()) == false ||
+            in_table(e[4].v_int, symbols.size()) == false ||
+            in_table(e[5].v_int, symbols.size()) == false ||
+            in_table(e[6].v_int, 2) == false ||
+            in_table(e[7].v_int, 2) == false) {
+          return false;
+        }
+        filled += 1;
+        SymbolGroup& o = *slot;
+        if (read_string(e[2], &o.name) == false) {
+          return false;
+        }
+        o.container = e[3].v_int;
+        o.start = e[4].v_int;
+        o.end = e[5].v_int;
+        o.advance_mode = (AdvanceModeType::T)e[6].v_int;
+        o.ending_mode = (EndingModeType::T)e[7].v_int;
+        o.nesting_groups.reserve(e[9].v_int);
+        for (int16_t i = 0; i < e[9].v_int; i++) {
+          if (in_table(e[10+i].v_int, symbol_groups.size()) == false) {
+            return false;
+          }
+          o.nesting_groups.push_back(e[10+i].v_int);
         }
       }
       break;
     case 'R': {
-        Production& o = productions[v[1].v_int];
-        o.index = v[1].v_int;
-        o.head = v[2].v_int;
-        for (int16_t i = 4; i < value_count; i++) {
-          o.handles.push_back(v[i].v_int);
+        Production* slot = take_slot(&productions, index);
+        if (slot == NULL_PTR || count < 4 ||
+            in_table(e[2].v_int, symbols.size()) == false) {
+          return false;
+        }
+        filled += 1;
+        Production& o = *slot;
+        o.head = e[2].v_int;
+        o.handles.reserve(count - 4);
+        for (int i = 4; i < count; i++) {
+          if (in_table(e[i].v_int, symbols.size()) == false) {
+            return false;
+          }
+          o.handles.push_back(e[i].v_int);
         }
       }
       break;
     case 'I': {
-        dfa_init = v[1].v_int;
-        lalr_init = v[2].v_int;
+        if (count < 3) {
+          return false;
+        }
+        dfa_init = e[1].v_int;
+        lalr_init = e[2].v_int;
       }
       break;
     case 'D': {
-        DFAState& o = dfa_states[v[1].v_int];
-        o.index = v[1].v_int;
-        o.accept_symbol = v[2].v_bool ? v[3].v_int : -1;
-        for (int16_t i = 0; i < (value_count - 5) / 3; i++) {
+        DFAState* slot = take_slot(&dfa_states, index);
+        if (slot == NULL_PTR || count < 5 ||
+            (e[2].v_int && in_table(e[3].v_int, symbols.size()) == false)) {
+          return false;
+        }
+        filled += 1;
+        DFAState& o = *slot;
+        o.accept_symbol = e[2].v_int ? e[3].v_int : -1;
+        o.edges.reserve((count - 5) / 3);
+        for (int i = 0; i < (count - 5) / 3; i++) {
+          if (in_table(e[i*3+5].v_int, charsets.size()) == false ||
+              in_table(e[i*3+6].v_int, dfa_states.size()) == false) {
+            return false;
+          }
           DFAEdge edge;
-          edge.charset = v[i*3+5].v_int;
-          edge.target = v[i*3+6].v_int;
+          edge.charset = e[i*3+5].v_int;
+          edge.target = e[i*3+6].v_int;
           o.edges.push_back(edge);
         }
       }
       break;
     case 'L': {
-        LALRState& o = lalr_states[v[1].v_int];
-        o.index = v[1].v_int;
-        for (int16_t i = 0; i < (value_count - 3) / 4; i++) {
-          LALRAction& action = o.actions[v[i*4+3].v_int];
-          action.symbol = v[i*4+3].v_int;
-          action.type = (LALRActionType::T)v[i*4+4].v_int;
-          action.target = v[i*4+5].v_int;
+        LALRState* slot = take_slot(&lalr_states, index);
+        if (slot == NULL_PTR || count < 3) {
+          return false;
+        }
+        filled += 1;
+        LALRState& o = *slot;
+        for (int i = 0; i < (count - 3) / 4; i++) {
+          LALRAction action;
+          action.symbol = e[i*4+3].v_int;
+          action.target = e[i*4+5].v_int;
+          if (in_table(action.symbol, symbols.size()) == false) {
+            return false;
+          }
+          switch (e[i*4+4].v_int) {
+          case LALRActionType::kShift:
+          case LALRActionType::kGoto:
+            if (in_table(action.target, lalr_states.size()) == false) {
+              return false;
+            }
+            break;
+          case LALRActionType::kReduce:
+            if (in_table(action.target, productions.size()) == false) {
+              return false;
+            }
+            break;
+          case LALRActionType::kAccept:
+            break;
+          default:
+            return false;
+          }
+          action.type = (LALRActionType::T)e[i*4+4].v_int;
+          // actions come in order of symbols mostly and an end is a hint
+          o.actions.insert(o.actions.end(),
+                           std::make_pair(action.symbol, action))->second =
+              action;
         }
       }
       break;
@@ -232,16 +447,44 @@ bool Grammar::LoadBuffer(const char* buf, size_t len) {
     }
   }
 
+  // a truncated buffer leaves tables not filled. no slot is filled twice,
+  // so a count of filled slots tells whether every slot is.
+  if (filled != symbols.size() + charsets.size() + symbol_groups.size() +
+                productions.size() + dfa_states.size() + lalr_states.size() ||
+      dfa_init < 0 || size_t(dfa_init) >= dfa_states.size() ||
+      lalr_init < 0 || size_t(lalr_init) >= lalr_states.size()) {
+    return false;
+  }
+
+  // a lexer and a parser need symbols of an end of a file and an error
+  int special_symbols = 0;
+  for (auto i = symbols.begin(), i_end = symbols.end(); i != i_end; ++i) {
+    if (i->type == SymbolType::kEndOfFile) {
+      special_symbols |= 1;
+    } else if (i->type == SymbolType::kError) {
+      special_symbols |= 2;
+    }
+  }
+  if (special_symbols != 3) {
+    return false;
+  }
+
   ProcessAfterLoad();
   return true;
 }
 
 void Grammar::ProcessAfterLoad() {
   LinkReference();
-  BuildDFALookup();
-  BuildLALRLookup();
+  // single lexemes are found on a DFA as it's written
   SetSingleLexemeSymbol();
   SetSimplicationRule();
+  Minimize(minimize_);
+  layout_applied_ = ApplyLayout();
+  PrepareProfiling();
+  BuildDFALookup();
+  BuildLALRLookup();
+  dfa_direct_ = !counters_->dfa_built && !counters_->dfa_visits;
+  lalr_direct_ = !counters_->lalr_built && !counters_->lalr_visits;
 }
 
 void Grammar::LinkReference() {
@@ -265,6 +508,8 @@ void Grammar::LinkReference() {
     }
   }
 
+  symbol_pname_lookup_.clear();
+  production_pname_lookup_.clear();
   for (auto i = symbols.begin(),
             i_end = symbols.end();
        i != i_end; ++i) {
@@ -279,52 +524,161 @@ void Grammar::LinkReference() {
 }
 
 void Grammar::BuildDFALookup() {
+  if (lazy_lookup_) {
+    counters_->dfa_built.reset(new std::atomic<bool>[dfa_states.size()]);
+    for (size_t i = 0; i < dfa_states.size(); i++) {
+      counters_->dfa_built[i].store(false, std::memory_order_relaxed);
+    }
+    return;
+  }
+
+  counters_->dfa_built.reset();
   for (auto i = dfa_states.begin(), i_end = dfa_states.end(); i != i_end; ++i) {
-    DFAState& s = *i;
-    memset(s.jmp_table, 0xFF, sizeof(s.jmp_table));
-    for (auto j = s.edges.begin(), j_end = s.edges.end(); j != j_end; ++j) {
-      const DFAEdge& e = *j;
-      const CharacterSet& cset = charsets[e.charset];
-      for (auto k = cset.ranges.begin(),
-                k_end = cset.ranges.end();
-           k != k_end; ++k) {
-        int16_t target = e.target;
-        if (e.target == s.index) {
-          target = (s.accept_symbol != -1) ? -2 : -3;
-        }
-        if (k->first < 0x80) {
-          for (int x = k->first; x <= std::min<uint16_t>(0x7F, k->second); ++x) {
-            s.jmp_table[x] = target;
-          }
-        }
-        if (k->second >= 0x80) {
-          DFAState::JmpRange jr;
-          jr.range_from = std::max<uint16_t>(0x80, k->first);
-          jr.range_to = k->second;
-          jr.target = target;
-          s.jmp_ranges.push_back(jr);
+    BuildDFALookup(&*i);
+  }
+}
+
+void Grammar::BuildLALRLookup() {
+  if (lazy_lookup_) {
+    counters_->lalr_built.reset(new std::atomic<bool>[lalr_states.size()]);
+    for (size_t i = 0; i < lalr_states.size(); i++) {
+      counters_->lalr_built[i].store(false, std::memory_order_relaxed);
+    }
+    return;
+  }
+
+  counters_->lalr_built.reset();
+  for (auto i = lalr_states.begin(), i_end = lalr_states.end(); i != i_end; ++i) {
+    BuildLALRLookup(&*i);
+  }
+}
+
+void Grammar::BuildDFALookup(DFAState* state) const {
+  DFAState& s = *state;
+  memset(s.jmp_table, 0xFF, sizeof(s.jmp_table));
+  size_t jmp_range_count = 0;
+  for (auto j = s.edges.begin(), j_end = s.edges.end(); j != j_end; ++j) {
+    const CharacterSet& cset = charsets[j->charset];
+    for (auto k = cset.ranges.begin(),
+              k_end = cset.ranges.end();
+         k != k_end; ++k) {
+      jmp_range_count += (k->second >= 0x80) ? 1 : 0;
+    }
+  }
+  s.jmp_ranges.clear();
+  s.jmp_ranges.reserve(jmp_range_count);
+  for (auto j = s.edges.begin(), j_end = s.edges.end(); j != j_end; ++j) {
+    const DFAEdge& e = *j;
+    const CharacterSet& cset = charsets[e.charset];
+    for (auto k = cset.ranges.begin(),
+              k_end = cset.ranges.end();
+         k != k_end; ++k) {
+      int16_t target = e.target;
+      if (e.target == s.index) {
+        target = (s.accept_symbol != -1) ? -2 : -3;
+      }
+      if (k->first < 0x80) {
+        for (int x = k->first; x <= std::min<uint16_t>(0x7F, k->second); ++x) {
+          s.jmp_table[x] = target;
         }
       }
+      if (k->second >= 0x80) {
+        DFAState::JmpRange jr;
+        jr.range_from = std::max<uint16_t>(0x80, k->first);
+        jr.range_to = k->second;
+        jr.target = target;
+        s.jmp_ranges.push_back(jr);
+      }
     }
+  }
 
-    struct JmpRangeLess {
-      bool operator()(const DFAState::JmpRange& a,
-                      const DFAState::JmpRange& b) {
-        return a.range_from < b.range_from;
-      }
-    };
-    std::sort(s.jmp_ranges.begin(), s.jmp_ranges.end(), JmpRangeLess());
+  struct JmpRangeLess {
+    bool operator()(const DFAState::JmpRange& a,
+                    const DFAState::JmpRange& b) {
+      return a.range_from < b.range_from;
+    }
+  };
+  std::sort(s.jmp_ranges.begin(), s.jmp_ranges.end(), JmpRangeLess());
+}
+
+void Grammar::BuildLALRLookup(LALRState* state) const {
+  LALRState& s = *state;
+  s.jmp_table.assign(symbols.size(), NULL_PTR);
+  for (auto j = s.actions.begin(), j_end = s.actions.end(); j != j_end; ++j) {
+    s.jmp_table[j->first] = &j->second;
   }
 }
 
-void Grammar::BuildLALRLookup() {
-  for (auto i = lalr_states.begin(), i_end = lalr_states.end(); i != i_end; ++i) {
-    LALRState& s = *i;
-    s.jmp_table.resize(symbols.size(), NULL_PTR);
-    for (auto j = s.actions.begin(), j_end = s.actions.end(); j != j_end; ++j) {
-      s.jmp_table[j->first] = &j->second;
+// a lookup is built once under a lock and a flag publishes it to threads
+// which check it without a lock.
+void Grammar::EnterDFAState(int index) const {
+  StateCounters& c = *counters_;
+  if (c.dfa_built &&
+      c.dfa_built[index].load(std::memory_order_acquire) == false) {
+    std::lock_guard<std::mutex> lock(c.lookup_mutex);
+    if (c.dfa_built[index].load(std::memory_order_relaxed) == false) {
+      BuildDFALookup(const_cast<DFAState*>(&dfa_states[index]));
+      c.dfa_built[index].store(true, std::memory_order_release);
+    }
+  }
+  if (c.dfa_visits) {
+    c.dfa_visits[index].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Grammar::EnterLALRState(int index) const {
+  StateCounters& c = *counters_;
+  if (c.lalr_built &&
+      c.lalr_built[index].load(std::memory_order_acquire) == false) {
+    std::lock_guard<std::mutex> lock(c.lookup_mutex);
+    if (c.lalr_built[index].load(std::memory_order_relaxed) == false) {
+      BuildLALRLookup(const_cast<LALRState*>(&lalr_states[index]));
+      c.lalr_built[index].store(true, std::memory_order_release);
     }
   }
+  if (c.lalr_visits) {
+    c.lalr_visits[index].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+bool Grammar::GetProfile(GrammarProfile* profile) const {
+  const StateCounters& c = *counters_;
+  if (c.dfa_visits == NULL_PTR) {
+    return false;
+  }
+
+  profile->fingerprint = fingerprint_;
+  profile->dfa_visits.resize(dfa_states.size());
+  for (size_t i = 0; i < dfa_states.size(); i++) {
+    profile->dfa_visits[i] = c.dfa_visits[i].load(std::memory_order_relaxed);
+  }
+  profile->lalr_visits.resize(lalr_states.size());
+  for (size_t i = 0; i < lalr_states.size(); i++) {
+    profile->lalr_visits[i] = c.lalr_visits[i].load(std::memory_order_relaxed);
+  }
+  return true;
+}
+
+void Grammar::PrepareProfiling() {
+  StateCounters& c = *counters_;
+  if (profiling_ == false) {
+    c.dfa_visits.reset();
+    c.lalr_visits.reset();
+    return;
+  }
+
+  c.dfa_visits.reset(new std::atomic<uint64_t>[dfa_states.size()]);
+  for (size_t i = 0; i < dfa_states.size(); i++) {
+    c.dfa_visits[i].store(0, std::memory_order_relaxed);
+  }
+  c.lalr_visits.reset(new std::atomic<uint64_t>[lalr_states.size()]);
+  for (size_t i = 0; i < lalr_states.size(); i++) {
+    c.lalr_visits[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void Grammar::SetLazyLookup(bool lazy) {
+  lazy_lookup_ = lazy;
 }
 
 void Grammar::SetSingleLexemeSymbol() {
@@ -430,4 +784,8 @@ Production* Grammar::GetProduction(const char* id) const {
   return GetProduction(utf8_string(reinterpret_cast<const byte*>(id)));
 }
 
+const Hash128& Grammar::GetFingerprint() const {
+  return fingerprint_;
+}
+
 }
@@ -0,0 +1,90 @@
+// Copyright 2012 Esun Kim
+
+#include "hash.h"
+#include <string.h>
+
+namespace cppauparser {
+
+Hash128::Hash128()
+    : low(0),
+      high(0) {
+}
+
+Hash128::Hash128(uint64_t low, uint64_t high)
+    : low(low),
+      high(high) {
+}
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+static inline uint64_t read64(const unsigned char* p) {
+  // memcpy for an unaligned read. it's compiled into a single load.
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+Hash128 HashBytes(const void* buf, size_t size, uint64_t seed) {
+  const unsigned char* data = static_cast<const unsigned char*>(buf);
+  const size_t nblocks = size / 16;
+  const uint64_t c1 = 0x87c37b91114253d5ULL;
+  const uint64_t c2 = 0x4cf5ad432745937fULL;
+  uint64_t h1 = seed;
+  uint64_t h2 = seed;
+
+  for (size_t i = 0; i < nblocks; i++) {
+    uint64_t k1 = read64(data + i * 16);
+    uint64_t k2 = read64(data + i * 16 + 8);
+
+    k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+    h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+    k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+    h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+  }
+
+  const unsigned char* tail = data + nblocks * 16;
+  uint64_t k1 = 0;
+  uint64_t k2 = 0;
+  switch (size & 15) {
+  case 15: k2 ^= static_cast<uint64_t>(tail[14]) << 48;
+  case 14: k2 ^= static_cast<uint64_t>(tail[13]) << 40;
+  case 13: k2 ^= static_cast<uint64_t>(tail[12]) << 32;
+  case 12: k2 ^= static_cast<uint64_t>(tail[11]) << 24;
+  case 11: k2 ^= static_cast<uint64_t>(tail[10]) << 16;
+  case 10: k2 ^= static_cast<uint64_t>(tail[9]) << 8;
+  case 9:  k2 ^= static_cast<uint64_t>(tail[8]);
+    k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+  case 8:  k1 ^= static_cast<uint64_t>(tail[7]) << 56;
+  case 7:  k1 ^= static_cast<uint64_t>(tail[6]) << 48;
+  case 6:  k1 ^= static_cast<uint64_t>(tail[5]) << 40;
+  case 5:  k1 ^= static_cast<uint64_t>(tail[4]) << 32;
+  case 4:  k1 ^= static_cast<uint64_t>(tail[3]) << 24;
+  case 3:  k1 ^= static_cast<uint64_t>(tail[2]) << 16;
+  case 2:  k1 ^= static_cast<uint64_t>(tail[1]) << 8;
+  case 1:  k1 ^= static_cast<uint64_t>(tail[0]);
+    k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+  }
+
+  h1 ^= size;
+  h2 ^= size;
+  h1 += h2;
+  h2 += h1;
+  h1 = fmix64(h1);
+  h2 = fmix64(h2);
+  h1 += h2;
+  h2 += h1;
+  return Hash128(h1, h2);
+}
+
+}  // namespace cppauparser
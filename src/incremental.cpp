@@ -0,0 +1,414 @@
+// Copyright 2012 Esun Kim
+
+#include "incremental.h"
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+namespace cppauparser {
+
+static const size_t kNoOffset = static_cast<size_t>(-1);
+
+TextEdit::TextEdit()
+    : start(0),
+      old_end(0),
+      new_end(0) {
+}
+
+TextEdit::TextEdit(size_t start, size_t old_end, size_t new_end)
+    : start(start),
+      old_end(old_end),
+      new_end(new_end) {
+}
+
+// merge two successive edits into one edit on the first text
+static TextEdit ComposeEdit(const TextEdit& a, const TextEdit& b) {
+  TextEdit e;
+  e.start = std::min(a.start, b.start);
+  e.old_end = (b.old_end > a.new_end)
+      ? b.old_end + a.old_end - a.new_end
+      : a.old_end;
+  e.new_end = std::max(a.new_end, b.old_end) + b.new_end - b.old_end;
+  return e;
+}
+
+// find a first or last terminal node of subtree
+static const TreeNodeTerminal* FindTerminal(const TreeNode* node, bool first) {
+  std::vector<const TreeNode*> nodes;
+  nodes.push_back(node);
+  while (nodes.empty() == false) {
+    const TreeNode* n = nodes.back();
+    nodes.pop_back();
+    if (n->IsTerminal()) {
+      return static_cast<const TreeNodeTerminal*>(n);
+    }
+    const TreeNodeNonTerminal* nt = static_cast<const TreeNodeNonTerminal*>(n);
+    for (int i = 0; i < nt->child_count; i++) {
+      nodes.push_back(nt->childs[first ? nt->child_count - 1 - i : i]);
+    }
+  }
+  return NULL_PTR;
+}
+
+static std::pair<int, int> RebasePosition(std::pair<int, int> position,
+                                          std::pair<int, int> old_position,
+                                          std::pair<int, int> new_position) {
+  // a column moves only on the line where a subtree starts
+  if (position.first == old_position.first) {
+    position.second += new_position.second - old_position.second;
+  }
+  position.first += new_position.first - old_position.first;
+  return position;
+}
+
+IncrementalParser::IncrementalParser(const Grammar& grammar)
+    : grammar_(grammar),
+      parser_(grammar),
+      result_(NULL_PTR),
+      root_(NULL_PTR),
+      base_(0),
+      pending_(false),
+      reused_count_(0),
+      cursor_(0),
+      dep_max_(0) {
+}
+
+IncrementalParser::~IncrementalParser() {
+}
+
+bool IncrementalParser::Parse(const byte* buf, size_t size) {
+  Clear();
+  return Run(buf, size, NULL_PTR);
+}
+
+bool IncrementalParser::Reparse(const byte* buf, size_t size,
+                                const TextEdit& edit) {
+  if (root_ == NULL_PTR) {
+    return Run(buf, size, NULL_PTR);
+  }
+
+  // an edit should be applied to the last text which is parsed successfully
+  TextEdit e = pending_ ? ComposeEdit(pending_edit_, edit) : edit;
+  if (Run(buf, size, &e)) {
+    return true;
+  } else {
+    pending_edit_ = e;
+    pending_ = true;
+    return false;
+  }
+}
+
+void IncrementalParser::Clear() {
+  result_ = NULL_PTR;
+  root_ = NULL_PTR;
+  base_ = 0;
+  infos_.clear();
+  order_.clear();
+  allocators_.clear();
+  pending_ = false;
+  reused_count_ = 0;
+}
+
+TreeNode* IncrementalParser::GetResult() const {
+  return result_;
+}
+
+const ParseErrorInfo& IncrementalParser::GetErrorInfo() const {
+  return parser_.GetErrorInfo();
+}
+
+size_t IncrementalParser::GetReusedNodeCount() const {
+  return reused_count_;
+}
+
+bool IncrementalParser::Run(const byte* buf, size_t size,
+                            const TextEdit* edit) {
+  parser_.LoadBuffer(buf, size);
+
+  std::shared_ptr<TreeNodeAllocator> allocator =
+      std::make_shared<TreeNodeAllocator>();
+  items_.clear();
+  new_infos_.clear();
+  splices_.clear();
+  cursor_ = 0;
+  dep_max_ = 0;
+  reused_count_ = 0;
+  result_ = NULL_PTR;
+
+  bool reusable = (edit != NULL_PTR && infos_.empty() == false);
+  while (true) {
+    if (reusable) {
+      // try to reuse a subtree before a lookahead is shifted
+      const Token& t = parser_.ReadLookahead();
+      if (t.symbol->type != SymbolType::kError && t.lexeme.empty() == false) {
+        const LALRAction* a = parser_.GetState()->jmp_table[t.symbol->index];
+        if (a && a->type == LALRActionType::kShift &&
+            Reuse(buf, size, *edit)) {
+          continue;
+        }
+      }
+    }
+
+    ParseResultType::T ret = parser_.ParseStep();
+    if (ret == ParseResultType::kShift) {
+      const Token& t = parser_.GetToken();
+      Item item = { allocator->Create(t),
+                    static_cast<size_t>(t.lexeme.c_str() - buf),
+                    0 };
+      items_.push_back(item);
+    } else if (ret == ParseResultType::kReduce) {
+      // a reduction depends on every byte scanned until now
+      dep_max_ = std::max(dep_max_, GetScanDependency(size));
+
+      const ParseReduction& r = parser_.GetReduction();
+      int child_count = static_cast<int>(r.handles->size());
+      TreeNodeNonTerminal* node = allocator->Create(r.production, child_count);
+      Item head = { node, kNoOffset, 1 };
+      size_t base = items_.size() - child_count;
+      for (int i = 0; i < child_count; i++) {
+        const Item& c = items_[base + i];
+        node->childs[i] = c.node;
+        head.count += c.count;
+        if (head.begin == kNoOffset) {
+          head.begin = c.begin;
+        }
+      }
+      items_.resize(base);
+      items_.push_back(head);
+
+      const ParseItemVector& stack = parser_.GetStack();
+      NodeInfo info = { node, head.begin, dep_max_,
+                        stack[stack.size() - 2].state->index, head.count };
+      new_infos_.push_back(info);
+    } else if (ret == ParseResultType::kAccept) {
+      break;
+    } else if (ret == ParseResultType::kError) {
+      return false;
+    }
+  }
+
+  Commit(buf, allocator);
+  return true;
+}
+
+bool IncrementalParser::Reuse(const byte* buf, size_t size,
+                              const TextEdit& edit) {
+  const Token& t = parser_.GetToken();
+  size_t p_new = t.lexeme.c_str() - buf;
+
+  // map a position on a new text to an old one
+  size_t p_old;
+  ptrdiff_t shift;
+  if (p_new < edit.start) {
+    p_old = p_new;
+    shift = 0;
+  } else if (p_new >= edit.new_end) {
+    p_old = p_new - edit.new_end + edit.old_end;
+    shift = static_cast<ptrdiff_t>(edit.new_end) -
+            static_cast<ptrdiff_t>(edit.old_end);
+  } else {
+    return false;
+  }
+
+  // candidates are visited in preorder, which is sorted by first tokens
+  while (cursor_ < order_.size()) {
+    size_t begin = infos_[order_[cursor_]].begin;
+    if (begin != kNoOffset && begin >= p_old) {
+      break;
+    }
+    cursor_ += 1;
+  }
+
+  int state = parser_.GetState()->index;
+  for (size_t k = cursor_; k < order_.size(); k++) {
+    size_t index = order_[k];
+    const NodeInfo& info = infos_[index];
+    if (info.begin == kNoOffset) {
+      continue;
+    }
+    if (info.begin != p_old) {
+      break;
+    }
+    if (info.state != state ||
+        (info.dep_end > edit.start && info.begin < edit.old_end)) {
+      continue;
+    }
+
+    // reposition a lexer after the last token of a subtree
+    const TreeNodeTerminal* first = FindTerminal(info.node, true);
+    const TreeNodeTerminal* last = FindTerminal(info.node, false);
+    Splice splice = { info.node, shift, first->token.position, t.position };
+    size_t last_offset = static_cast<size_t>(
+        reinterpret_cast<uintptr_t>(last->token.lexeme.c_str()) - base_ + shift);
+    size_t end_offset = last_offset + last->token.lexeme.size();
+    std::pair<int, int> end_position = Lexer::AdvancePosition(
+        RebasePosition(last->token.position,
+                       splice.old_position, splice.new_position),
+        buf + last_offset, last->token.lexeme.size());
+
+    dep_max_ = std::max(dep_max_, GetScanDependency(size));
+    if (parser_.ShiftSubtree(info.node->production, info.node,
+                             end_offset, end_position) == false) {
+      return false;
+    }
+    dep_max_ = std::max(dep_max_, info.dep_end + shift);
+
+    Item item = { info.node, p_new, info.count };
+    items_.push_back(item);
+
+    // copy infos of a subtree which are contiguous in postfix order
+    size_t n = new_infos_.size();
+    new_infos_.insert(new_infos_.end(),
+                      infos_.begin() + (index + 1 - info.count),
+                      infos_.begin() + (index + 1));
+    for (size_t i = n, i_end = new_infos_.size(); i < i_end; ++i) {
+      if (new_infos_[i].begin != kNoOffset) {
+        new_infos_[i].begin += shift;
+      }
+      new_infos_[i].dep_end += shift;
+    }
+
+    splices_.push_back(splice);
+    reused_count_ += info.count;
+    cursor_ = k + info.count;
+    return true;
+  }
+
+  return false;
+}
+
+size_t IncrementalParser::GetScanDependency(size_t size) const {
+  // a scan reaching the end depends on what would be appended
+  size_t offset = parser_.GetLexer().GetScanOffset();
+  return offset >= size ? size + 1 : offset;
+}
+
+void IncrementalParser::Commit(const byte* buf,
+                               std::shared_ptr<TreeNodeAllocator> allocator) {
+  // move reused subtrees onto a new text
+  size_t live_bytes = allocator->GetUsedBytes();
+  for (auto i = splices_.begin(), i_end = splices_.end(); i != i_end; ++i) {
+    live_bytes += RebaseSubtree(buf, *i);
+  }
+
+  root_ = result_ = items_.back().node;
+  base_ = reinterpret_cast<uintptr_t>(buf);
+  infos_.swap(new_infos_);
+  new_infos_.clear();
+  allocators_.push_back(allocator);
+  pending_ = false;
+
+  // nodes of old generations which are not reused any more are garbage.
+  // copy a whole tree to a new allocator when garbage takes over.
+  size_t total_bytes = 0;
+  for (auto i = allocators_.begin(), i_end = allocators_.end(); i != i_end; ++i) {
+    total_bytes += (*i)->GetUsedBytes();
+  }
+  if (total_bytes > live_bytes * 2 + 65536) {
+    Compact();
+  }
+
+  BuildOrder();
+}
+
+size_t IncrementalParser::RebaseSubtree(const byte* buf, const Splice& splice) {
+  size_t bytes = 0;
+  std::vector<TreeNode*> nodes;
+  nodes.push_back(splice.node);
+  while (nodes.empty() == false) {
+    TreeNode* n = nodes.back();
+    nodes.pop_back();
+    if (n->IsTerminal()) {
+      Token& token = static_cast<TreeNodeTerminal*>(n)->token;
+      size_t offset = static_cast<size_t>(
+          reinterpret_cast<uintptr_t>(token.lexeme.c_str()) - base_ +
+          splice.shift);
+      token.lexeme = utf8_substring(buf + offset, token.lexeme.size());
+      token.position = RebasePosition(token.position,
+                                      splice.old_position,
+                                      splice.new_position);
+      bytes += sizeof(TreeNodeTerminal);
+    } else {
+      TreeNodeNonTerminal* nt = static_cast<TreeNodeNonTerminal*>(n);
+      for (int i = 0; i < nt->child_count; i++) {
+        nodes.push_back(nt->childs[i]);
+      }
+      bytes += TreeNodeNonTerminal::CalculateObjectSize(nt->child_count);
+    }
+  }
+  return bytes;
+}
+
+void IncrementalParser::BuildOrder() {
+  // make preorder from postfix infos. children of infos[i] are found
+  // from right to left by skipping each subtree.
+  order_.clear();
+  order_.reserve(infos_.size());
+  if (infos_.empty()) {
+    return;
+  }
+
+  std::vector<size_t> indices;
+  indices.push_back(infos_.size() - 1);
+  while (indices.empty() == false) {
+    size_t i = indices.back();
+    indices.pop_back();
+    order_.push_back(i);
+    size_t first = i + 1 - infos_[i].count;
+    for (size_t j = i; j > first; ) {
+      j -= 1;
+      indices.push_back(j);
+      j = j + 1 - infos_[j].count;
+    }
+  }
+}
+
+void IncrementalParser::Compact() {
+  std::shared_ptr<TreeNodeAllocator> allocator =
+      std::make_shared<TreeNodeAllocator>();
+
+  // copy in postfix order, which is the same order as infos
+  struct Frame {
+    const TreeNode* node;
+    int next;
+  };
+  std::vector<Frame> frames;
+  std::vector<TreeNode*> nodes;
+  size_t info_index = 0;
+  Frame root = { root_, 0 };
+  frames.push_back(root);
+  while (frames.empty() == false) {
+    Frame& f = frames.back();
+    if (f.node->IsTerminal()) {
+      nodes.push_back(allocator->Create(
+          static_cast<const TreeNodeTerminal*>(f.node)->token));
+      frames.pop_back();
+      continue;
+    }
+
+    const TreeNodeNonTerminal* nt = static_cast<const TreeNodeNonTerminal*>(f.node);
+    if (f.next < nt->child_count) {
+      Frame c = { nt->childs[f.next], 0 };
+      f.next += 1;
+      frames.push_back(c);
+      continue;
+    }
+
+    TreeNodeNonTerminal* node = allocator->Create(nt->production,
+                                                  nt->child_count);
+    size_t base = nodes.size() - nt->child_count;
+    for (int i = 0; i < nt->child_count; i++) {
+      node->childs[i] = nodes[base + i];
+    }
+    nodes.resize(base);
+    nodes.push_back(node);
+    infos_[info_index++].node = node;
+    frames.pop_back();
+  }
+
+  root_ = result_ = nodes.back();
+  allocators_.clear();
+  allocators_.push_back(allocator);
+}
+
+}  // namespace cppauparser
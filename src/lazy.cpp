@@ -0,0 +1,186 @@
+// Copyright 2012 Esun Kim
+
+#include "lazy.h"
+#include <new>
+
+namespace cppauparser {
+
+TreeNodeLazy::TreeNodeLazy(const Production* production,
+                           const LALRState* state, size_t offset,
+                           size_t size, std::pair<int, int> position)
+    : TreeNodeNonTerminal(production, -1),
+      state(state),
+      offset(offset),
+      size(size),
+      position(position),
+      materialized(NULL_PTR) {
+}
+
+LazyParser::LazyParser(const Grammar& grammar)
+    : grammar_(grammar),
+      parser_(grammar),
+      scanner_(grammar),
+      lazy_by_open_(grammar.symbols.size(), -1),
+      buf_(NULL_PTR),
+      size_(0),
+      result_(NULL_PTR),
+      skipped_count_(0) {
+}
+
+LazyParser::~LazyParser() {
+}
+
+bool LazyParser::SetLazy(const char* symbol_id, const char* open_id,
+                         const char* close_id) {
+  const Symbol* symbol = grammar_.GetSymbol(symbol_id);
+  const Symbol* open = grammar_.GetSymbol(open_id);
+  const Symbol* close = grammar_.GetSymbol(close_id);
+  if (symbol == NULL_PTR || symbol->type != SymbolType::kNonTerminal ||
+      open == NULL_PTR || close == NULL_PTR || open == close ||
+      lazy_by_open_[open->index] != -1) {
+    return false;
+  }
+
+  const Production* production = NULL_PTR;
+  for (auto i = grammar_.productions.begin(),
+            i_end = grammar_.productions.end();
+       i != i_end; ++i) {
+    if (i->head == symbol->index) {
+      production = &*i;
+      break;
+    }
+  }
+  if (production == NULL_PTR) {
+    return false;
+  }
+
+  Lazy lazy = { symbol, production, open->index, close->index };
+  lazy_by_open_[open->index] = static_cast<int>(lazies_.size());
+  lazies_.push_back(lazy);
+  return true;
+}
+
+bool LazyParser::Parse(const byte* buf, size_t size) {
+  buf_ = buf;
+  size_ = size;
+  result_ = NULL_PTR;
+  skipped_count_ = 0;
+  builder_.result = NULL_PTR;
+  builder_.allocator.Clear();
+  parser_.LoadBuffer(buf, size);
+  scanner_.LoadBuffer(buf, size);
+  return Run(NULL_PTR, &result_);
+}
+
+TreeNode* LazyParser::GetResult() const {
+  return result_;
+}
+
+TreeNode* LazyParser::Resolve(TreeNode* node) {
+  if (IsLazy(node) == false) {
+    return node;
+  }
+  TreeNodeLazy* lazy = static_cast<TreeNodeLazy*>(node);
+  if (lazy->materialized == NULL_PTR) {
+    Run(lazy, &lazy->materialized);
+  }
+  return lazy->materialized;
+}
+
+bool LazyParser::IsLazy(const TreeNode* node) {
+  return node->IsNonTerminal() &&
+         static_cast<const TreeNodeNonTerminal*>(node)->child_count == -1;
+}
+
+const ParseErrorInfo& LazyParser::GetErrorInfo() const {
+  return parser_.GetErrorInfo();
+}
+
+size_t LazyParser::GetSkippedCount() const {
+  return skipped_count_;
+}
+
+bool LazyParser::Run(TreeNodeLazy* from, TreeNode** result) {
+  // a lazy node is parsed from its state. it is done when its symbol is
+  // reduced right above the state and a first open token is its own.
+  if (from) {
+    parser_.ResetCursor(from->state, from->offset, from->position);
+  } else {
+    parser_.ResetCursor();
+  }
+  bool skip = (from == NULL_PTR);
+
+  while (true) {
+    if (skip && lazies_.empty() == false) {
+      const Token& t = parser_.ReadLookahead();
+      int l = lazy_by_open_[t.symbol->index];
+      if (l != -1 && Skip(lazies_[l], t)) {
+        continue;
+      }
+    }
+    skip = true;
+
+    ParseResultType::T ret = parser_.ParseStep();
+    builder_(ret, parser_);
+    if (ret == ParseResultType::kReduce) {
+      if (from && parser_.GetStack().size() == 2 &&
+          parser_.GetReduction().production->head ==
+              from->production->head) {
+        *result = reinterpret_cast<TreeNode*>(parser_.GetTop().data);
+        return true;
+      }
+    } else if (ret == ParseResultType::kAccept) {
+      *result = builder_.result;
+      return true;
+    } else if (ret == ParseResultType::kError) {
+      *result = NULL_PTR;
+      return false;
+    }
+  }
+}
+
+bool LazyParser::Skip(const Lazy& lazy, const Token& token) {
+  const LALRState* state = parser_.GetState();
+  const LALRAction* sa = state->jmp_table[lazy.open];
+  const LALRAction* ga = state->jmp_table[lazy.symbol->index];
+  if (sa == NULL_PTR || sa->type != LALRActionType::kShift ||
+      ga == NULL_PTR || ga->type != LALRActionType::kGoto) {
+    return false;
+  }
+
+  // scan symbols only up to a matching close
+  size_t begin = token.lexeme.c_str() - buf_;
+  scanner_.Seek(begin, token.position);
+  int depth = 0;
+  while (true) {
+    size_t offset;
+    const Symbol* symbol = scanner_.ReadSymbol(&offset);
+    if (symbol->index == lazy.open) {
+      depth += 1;
+    } else if (symbol->index == lazy.close) {
+      depth -= 1;
+      if (depth == 0) {
+        break;
+      }
+    } else if (symbol->type == SymbolType::kEndOfFile ||
+               symbol->type == SymbolType::kError) {
+      // not balanced. let a parser meet an error itself.
+      return false;
+    }
+  }
+
+  size_t end = scanner_.GetOffset();
+  void* p = builder_.allocator.Alloc(sizeof(TreeNodeLazy));
+  TreeNodeLazy* node = new (p) TreeNodeLazy(
+      lazy.production, state, begin, end - begin, token.position);
+  std::pair<int, int> end_position =
+      Lexer::AdvancePosition(token.position, buf_ + begin, end - begin);
+  if (parser_.ShiftSubtree(lazy.production, node, end, end_position) ==
+      false) {
+    return false;
+  }
+  skipped_count_ += 1;
+  return true;
+}
+
+}  // namespace cppauparser
@@ -25,6 +25,11 @@ utf8_string Token::GetString() const {
                                 lexeme.get_string().c_str());
 }
 
+LexerState::LexerState()
+    : offset(0),
+      position(std::make_pair(0, 0)) {
+}
+
 LexerBuffer::LexerBuffer()
     : buf_(NULL_PTR),
       buf_size_(0),
@@ -50,6 +55,10 @@ void LexerBuffer::SetBuffer(byte* buf, size_t size, bool sharable) {
   buf_sharable_ = sharable;
 }
 
+void LexerBuffer::AddChunk(byte* buf) {
+  chunks_.push_back(buf);
+}
+
 void LexerBuffer::Clear() {
   if (buf_) {
     if (buf_sharable_ == false) {
@@ -59,12 +68,17 @@ void LexerBuffer::Clear() {
   }
   buf_size_ = 0;
   buf_sharable_ = false;
+  for (auto i = chunks_.begin(), i_end = chunks_.end(); i != i_end; ++i) {
+    free(*i);
+  }
+  chunks_.clear();
 }
 
 void LexerBuffer::Swap(LexerBuffer& b) {
   std::swap(buf_, b.buf_);
   std::swap(buf_size_, b.buf_size_);
   std::swap(buf_sharable_, b.buf_sharable_);
+  chunks_.swap(b.chunks_);
 }
 
 Lexer::Lexer(const Grammar& grammar)
@@ -73,6 +87,10 @@ Lexer::Lexer(const Grammar& grammar)
     , buf_cur_(NULL_PTR)
     , buf_end_(NULL_PTR)
     , buf_peek_(NULL_PTR)
+    , buf_scan_(NULL_PTR)
+    , buf_cap_(NULL_PTR)
+    , buf_base_(0)
+    , stream_open_(false)
     , line_(0)
     , column_(0) {
 }
@@ -85,6 +103,10 @@ bool Lexer::LoadFile(const PATHCHAR* file_path) {
   Unload();
 
   FILE* fp = PATHOPEN(file_path, PATHSTR("rb"));
+  if (fp == NULL) {
+    return false;
+  }
+
   fseek(fp, 0, SEEK_END);
   size_t size = ftell(fp);
   fseek(fp, 0, SEEK_SET);
@@ -94,8 +116,8 @@ bool Lexer::LoadFile(const PATHCHAR* file_path) {
 
   allocator_.SetBuffer(buf_, size, false);
 
-  buf_cur_ = buf_;
-  buf_end_ = buf_ + size;
+  buf_scan_ = buf_cur_ = buf_;
+  buf_cap_ = buf_end_ = buf_ + size;
   line_ = 1;
   column_ = 1;
   return true;
@@ -110,36 +132,111 @@ bool Lexer::LoadBuffer(const byte* buf, size_t size) {
 
   allocator_.SetBuffer(const_cast<byte*>(buf), size, true);
 
-  buf_cur_ = buf_ = const_cast<byte*>(buf);
-  buf_end_ = buf_ + size;
+  buf_scan_ = buf_cur_ = buf_ = const_cast<byte*>(buf);
+  buf_cap_ = buf_end_ = buf_ + size;
   line_ = 1;
   column_ = 1;
   return true;
 }
 
 void Lexer::Unload() {
-  if (buf_) {
-    allocator_.Clear();
-    buf_ = NULL_PTR;
-    buf_cur_ = NULL_PTR;
-    buf_end_ = NULL_PTR;
-  }
+  allocator_.Clear();
+  buf_ = NULL_PTR;
+  buf_cur_ = NULL_PTR;
+  buf_end_ = NULL_PTR;
+  buf_scan_ = NULL_PTR;
+  buf_cap_ = NULL_PTR;
+  buf_base_ = 0;
+  stream_open_ = false;
+  group_stack_.clear();
 }
 
 void Lexer::ResetCursor() {
-  buf_cur_ = buf_;
+  buf_scan_ = buf_cur_ = buf_;
   line_ = 1;
   column_ = 1;
 }
 
+bool Lexer::LoadStream() {
+  Unload();
+
+  stream_open_ = true;
+  line_ = 1;
+  column_ = 1;
+  return true;
+}
+
+void Lexer::Feed(const byte* buf, size_t size) {
+  if (size == 0) {
+    return;
+  }
+
+  if (size <= static_cast<size_t>(buf_cap_ - buf_end_)) {
+    memcpy(buf_end_, buf, size);
+    buf_end_ += size;
+    return;
+  }
+
+  // move bytes not consumed yet (from the start of an open group) to
+  // a new chunk. old chunks are kept because tokens still refer to them.
+  byte* keep = buf_cur_;
+  if (group_stack_.empty() == false) {
+    keep = const_cast<byte*>(group_stack_.front().text.c_str());
+  }
+  size_t keep_size = buf_end_ - keep;
+  size_t cap = std::max<size_t>((keep_size + size) * 2, 4096);
+  byte* chunk = reinterpret_cast<byte*>(malloc(cap));
+  if (keep_size > 0) {
+    memcpy(chunk, keep, keep_size);
+  }
+  memcpy(chunk + keep_size, buf, size);
+  allocator_.AddChunk(chunk);
+
+  for (auto i = group_stack_.begin(), i_end = group_stack_.end();
+       i != i_end; ++i) {
+    i->text = utf8_substring(chunk + (i->text.c_str() - keep), i->text.size());
+  }
+  buf_cur_ = chunk + (buf_cur_ - keep);
+  buf_scan_ = chunk + (std::max(buf_scan_, buf_cur_) - keep);
+  buf_base_ += keep - buf_;
+  buf_ = chunk;
+  buf_end_ = chunk + keep_size + size;
+  buf_cap_ = chunk + cap;
+}
+
+void Lexer::Finish() {
+  stream_open_ = false;
+}
+
+bool Lexer::IsStreamOpen() const {
+  return stream_open_;
+}
+
+size_t Lexer::GetPendingSize() const {
+  const byte* keep = buf_cur_;
+  if (group_stack_.empty() == false) {
+    keep = group_stack_.front().text.c_str();
+  }
+  return buf_end_ - keep;
+}
+
 std::shared_ptr<LexerBuffer> Lexer::ReleaseBuffer() {
   std::shared_ptr<LexerBuffer> b = std::make_shared<LexerBuffer>();
   b->Swap(allocator_);
   return b;
 }
 
-void Lexer::PeekToken(Token* token) {
-  const DFAState* state = &grammar_.dfa_states[grammar_.dfa_init];
+// run DFA from buf_cur_. returns an accepted symbol (or -1) and sets
+// the end of it to hit_end and the end of scanned bytes to end.
+inline int Lexer::MatchToken(byte** hit_end, byte** end) {
+  return grammar_.IsDFADirect() ? MatchTokenIn<true>(hit_end, end)
+                                : MatchTokenIn<false>(hit_end, end);
+}
+
+// a direct one indexes states without a lazy lookup or profiling
+template<bool kDirect>
+inline int Lexer::MatchTokenIn(byte** hit_end, byte** end) {
+  const DFAState* state = grammar_.GetDFAState(grammar_.dfa_init);
   byte* cur = buf_cur_;
   int hit_symbol = -1;
   byte* hit_cur = NULL_PTR;
@@ -156,13 +253,19 @@ void Lexer::PeekToken(Token* token) {
       } else if (target == -1) {
         break;
       } else {
-        state = &grammar_.dfa_states[target];
+        state = kDirect ? &grammar_.dfa_states[target]
+                        : grammar_.GetDFAState(target);
         if (state->accept_symbol != -1) {
           hit_symbol = state->accept_symbol;
           hit_cur = cur;
         }
       }
     } else {
+      if (buf_end_ - cur < ((c < 0xE0) ? 2 : (c < 0xF0) ? 3 : 4)) {
+        // truncated sequence. the rest may come with a next feed
+        cur = buf_end_;
+        break;
+      }
       if (c < 0xE0) {
         c = ((c & 0x1F) << 6) | (cur[1] & 0x3F);
         cur += 2;
@@ -192,7 +295,8 @@ void Lexer::PeekToken(Token* token) {
       } else if (target == -1) {
         break;
       } else {
-        state = &grammar_.dfa_states[target];
+        state = kDirect ? &grammar_.dfa_states[target]
+                        : grammar_.GetDFAState(target);
         if (state->accept_symbol != -1) {
           hit_symbol = state->accept_symbol;
           hit_cur = cur;
@@ -201,6 +305,27 @@ void Lexer::PeekToken(Token* token) {
     }
   }
 
+  *hit_end = hit_cur;
+  *end = cur;
+  return hit_symbol;
+}
+
+void Lexer::PeekToken(Token* token) {
+  byte* hit_cur;
+  byte* cur;
+  int hit_symbol = MatchToken(&hit_cur, &cur);
+
+  if (cur > buf_scan_) {
+    buf_scan_ = cur;
+  }
+
+  if (cur == buf_end_ && stream_open_) {
+    // a token can be longer with bytes not fed yet
+    buf_peek_ = buf_cur_;
+    token->symbol = NULL_PTR;
+    return;
+  }
+
   if (hit_symbol != -1) {
     buf_peek_ = hit_cur;
     token->symbol = &grammar_.symbols[hit_symbol];
@@ -241,6 +366,10 @@ void Lexer::ReadToken(Token* token) {
     PeekToken(token);
 
     const Symbol* symbol = token->symbol;
+    if (symbol == NULL_PTR) {
+      // suspended in a stream
+      return;
+    }
     SymbolType::T symbol_type = symbol->type;
 
     bool nest_group;
@@ -316,6 +445,35 @@ void Lexer::ReadToken(Token* token) {
   }
 }
 
+const Symbol* Lexer::ReadSymbol(size_t* offset) {
+  *offset = buf_base_ + (buf_cur_ - buf_);
+  while (true) {
+    byte* hit_cur;
+    byte* cur;
+    int hit_symbol = MatchToken(&hit_cur, &cur);
+    if (hit_symbol == -1) {
+      if (cur == buf_cur_) {
+        return grammar_.symbol_EOF;
+      }
+      buf_cur_ = cur;
+      return grammar_.symbol_Error;
+    }
+
+    const Symbol* symbol = &grammar_.symbols[hit_symbol];
+    if (symbol->type == SymbolType::kGroupStart || !group_stack_.empty()) {
+      // groups are rare. leave them to a full path
+      Token token;
+      ReadToken(&token);
+      symbol = token.symbol;
+    } else {
+      buf_cur_ = hit_cur;
+    }
+    if (symbol->type != SymbolType::kNoise) {
+      return symbol;
+    }
+  }
+}
+
 int Lexer::GetLine() const {
   return line_;
 }
@@ -328,4 +486,77 @@ std::pair<int, int> Lexer::GetPosition() const {
   return std::make_pair(line_, column_);
 }
 
+size_t Lexer::GetOffset() const {
+  return buf_base_ + (buf_cur_ - buf_);
+}
+
+size_t Lexer::GetScanOffset() const {
+  return buf_base_ + (buf_scan_ - buf_);
+}
+
+void Lexer::Seek(size_t offset, std::pair<int, int> position) {
+  buf_scan_ = buf_cur_ = buf_ + (offset - buf_base_);
+  line_ = position.first;
+  column_ = position.second;
+  group_stack_.clear();
+}
+
+utf8_substring Lexer::GetText() const {
+  return utf8_substring(buf_, buf_end_ - buf_);
+}
+
+void Lexer::SaveState(LexerState* state) const {
+  state->offset = GetOffset();
+  state->position = GetPosition();
+  state->groups.clear();
+  for (auto i = group_stack_.begin(), i_end = group_stack_.end();
+       i != i_end; ++i) {
+    LexerState::Group g = {
+      i->symbol_group,
+      buf_base_ + (i->text.c_str() - buf_),
+      i->text.size() };
+    state->groups.push_back(g);
+  }
+}
+
+bool Lexer::RestoreState(const LexerState& state) {
+  size_t size = buf_end_ - buf_;
+  if (state.offset < buf_base_ || state.offset - buf_base_ > size) {
+    return false;
+  }
+  for (auto i = state.groups.begin(), i_end = state.groups.end();
+       i != i_end; ++i) {
+    if (i->offset < buf_base_ || i->offset - buf_base_ > size) {
+      return false;
+    }
+  }
+
+  buf_scan_ = buf_cur_ = buf_ + (state.offset - buf_base_);
+  line_ = state.position.first;
+  column_ = state.position.second;
+  group_stack_.clear();
+  for (auto i = state.groups.begin(), i_end = state.groups.end();
+       i != i_end; ++i) {
+    Group g = {
+      i->symbol_group,
+      utf8_substring(buf_ + (i->offset - buf_base_), i->size) };
+    group_stack_.push_back(g);
+  }
+  return true;
+}
+
+std::pair<int, int> Lexer::AdvancePosition(std::pair<int, int> position,
+                                           const byte* buf, size_t size) {
+  // same line counting rule as AdvanceBuffer
+  for (const byte* buf_end = buf + size; buf < buf_end; ++buf) {
+    if (*buf == 0x13) {
+      position.first += 1;
+      position.second = 1;
+    } else {
+      position.second += 1;
+    }
+  }
+  return position;
+}
+
 }
@@ -0,0 +1,346 @@
+// Copyright 2012 Esun Kim
+
+#include "grammar.h"
+#include <string.h>
+#include <algorithm>
+#include <map>
+
+namespace cppauparser {
+
+static MinimizeStats::Counts CountTables(const Grammar& grammar) {
+  MinimizeStats::Counts c;
+  c.dfa_states = grammar.dfa_states.size();
+  c.dfa_edges = 0;
+  for (auto i = grammar.dfa_states.begin(), i_end = grammar.dfa_states.end();
+       i != i_end; ++i) {
+    c.dfa_edges += i->edges.size();
+  }
+  c.charsets = grammar.charsets.size();
+  c.lalr_states = grammar.lalr_states.size();
+  return c;
+}
+
+void Grammar::Minimize(bool minimize) {
+  minimize_stats_.before = CountTables(*this);
+  if (minimize) {
+    bool changed = MinimizeDFA();
+    changed = PruneCharsets() || changed;
+    changed = PruneLALR() || changed;
+    if (changed) {
+      // tables are not ones of a file any more
+      fingerprint_ = HashBytes(&fingerprint_, sizeof(fingerprint_), 1);
+    }
+  }
+  minimize_stats_.after = CountTables(*this);
+}
+
+// Hopcroft's algorithm over classes of characters which ranges of charsets
+// split. a missing transition goes to a dead state which is kept apart from
+// states of a grammar, so that a lexer still stops scanning where it did.
+bool Grammar::MinimizeDFA() {
+  // states reachable from an initial state in order of indices
+  std::vector<int> ids(dfa_states.size(), -1);
+  std::vector<int> order;
+  ids[dfa_init] = 0;
+  order.push_back(dfa_init);
+  for (size_t i = 0; i < order.size(); i++) {
+    const DFAState& s = dfa_states[order[i]];
+    for (auto j = s.edges.begin(), j_end = s.edges.end(); j != j_end; ++j) {
+      if (ids[j->target] == -1) {
+        ids[j->target] = 0;
+        order.push_back(j->target);
+      }
+    }
+  }
+  std::sort(order.begin(), order.end());
+  for (size_t i = 0; i < order.size(); i++) {
+    ids[order[i]] = static_cast<int>(i);
+  }
+  const int n = static_cast<int>(order.size());
+  const int dead = n;
+
+  // classes of characters. [bounds[c], bounds[c+1])
+  std::vector<int32_t> bounds;
+  for (int i = 0; i < n; i++) {
+    const DFAState& s = dfa_states[order[i]];
+    for (auto j = s.edges.begin(), j_end = s.edges.end(); j != j_end; ++j) {
+      const CharacterSet& cset = charsets[j->charset];
+      for (auto k = cset.ranges.begin(), k_end = cset.ranges.end();
+           k != k_end; ++k) {
+        bounds.push_back(k->first);
+        bounds.push_back(int32_t(k->second) + 1);
+      }
+    }
+  }
+  std::sort(bounds.begin(), bounds.end());
+  bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+  const int K = bounds.empty() ? 0 : static_cast<int>(bounds.size()) - 1;
+
+  // transitions of a state by a class. edges of a state do not overlap.
+  std::vector<int> trans(size_t(n + 1) * K, dead);
+  for (int i = 0; i < n; i++) {
+    const DFAState& s = dfa_states[order[i]];
+    for (auto j = s.edges.begin(), j_end = s.edges.end(); j != j_end; ++j) {
+      const CharacterSet& cset = charsets[j->charset];
+      for (auto k = cset.ranges.begin(), k_end = cset.ranges.end();
+           k != k_end; ++k) {
+        int c_begin = static_cast<int>(
+            std::lower_bound(bounds.begin(), bounds.end(), k->first) -
+            bounds.begin());
+        int c_end = static_cast<int>(
+            std::lower_bound(bounds.begin(), bounds.end(),
+                             int32_t(k->second) + 1) - bounds.begin());
+        for (int c = c_begin; c < c_end; c++) {
+          trans[size_t(i) * K + c] = ids[j->target];
+        }
+      }
+    }
+  }
+
+  // sources of transitions into a state by a class.
+  // inv[inv_begin[c*(n+1)+t], inv_begin[c*(n+1)+t+1])
+  std::vector<int> inv_begin(size_t(n + 1) * K + 1, 0);
+  std::vector<int> inv(size_t(n + 1) * K);
+  for (int s = 0; s <= n; s++) {
+    for (int c = 0; c < K; c++) {
+      inv_begin[size_t(c) * (n + 1) + trans[size_t(s) * K + c] + 1] += 1;
+    }
+  }
+  for (size_t i = 1; i < inv_begin.size(); i++) {
+    inv_begin[i] += inv_begin[i - 1];
+  }
+  {
+    std::vector<int> fill(inv_begin.begin(), inv_begin.end() - 1);
+    for (int s = 0; s <= n; s++) {
+      for (int c = 0; c < K; c++) {
+        inv[fill[size_t(c) * (n + 1) + trans[size_t(s) * K + c]]++] = s;
+      }
+    }
+  }
+
+  // an initial partition by accepted symbols and a dead state alone
+  std::vector<int> block_of(n + 1);
+  std::vector<std::vector<int> > blocks;
+  {
+    std::map<int, int> by_accept;
+    for (int s = 0; s < n; s++) {
+      int accept = dfa_states[order[s]].accept_symbol;
+      auto b = by_accept.find(accept);
+      if (b == by_accept.end()) {
+        b = by_accept.insert(
+            std::make_pair(accept, static_cast<int>(blocks.size()))).first;
+        blocks.push_back(std::vector<int>());
+      }
+      block_of[s] = b->second;
+      blocks[b->second].push_back(s);
+    }
+    block_of[dead] = static_cast<int>(blocks.size());
+    blocks.push_back(std::vector<int>(1, dead));
+  }
+
+  std::vector<int> work;
+  std::vector<char> in_work(blocks.size(), 1);
+  for (size_t b = 0; b < blocks.size(); b++) {
+    work.push_back(static_cast<int>(b));
+  }
+  std::vector<size_t> counts(blocks.size(), 0);
+  std::vector<char> marked(n + 1, 0);
+  std::vector<int> x;
+  std::vector<int> touched;
+  while (work.empty() == false) {
+    int a = work.back();
+    work.pop_back();
+    in_work[a] = 0;
+    const std::vector<int> splitter = blocks[a];
+
+    for (int c = 0; c < K; c++) {
+      // states going into a splitter by a class
+      x.clear();
+      for (auto t = splitter.begin(), t_end = splitter.end();
+           t != t_end; ++t) {
+        size_t at = size_t(c) * (n + 1) + *t;
+        for (int i = inv_begin[at]; i < inv_begin[at + 1]; i++) {
+          if (marked[inv[i]] == 0) {
+            marked[inv[i]] = 1;
+            x.push_back(inv[i]);
+          }
+        }
+      }
+      if (x.empty()) {
+        continue;
+      }
+
+      touched.clear();
+      for (auto s = x.begin(), s_end = x.end(); s != s_end; ++s) {
+        if (counts[block_of[*s]]++ == 0) {
+          touched.push_back(block_of[*s]);
+        }
+      }
+      for (auto b = touched.begin(), b_end = touched.end(); b != b_end; ++b) {
+        if (counts[*b] < blocks[*b].size()) {
+          // split marked states into a new block
+          int z = static_cast<int>(blocks.size());
+          blocks.push_back(std::vector<int>());
+          in_work.push_back(0);
+          counts.push_back(0);
+          std::vector<int> rest;
+          for (auto s = blocks[*b].begin(), s_end = blocks[*b].end();
+               s != s_end; ++s) {
+            if (marked[*s]) {
+              blocks[z].push_back(*s);
+              block_of[*s] = z;
+            } else {
+              rest.push_back(*s);
+            }
+          }
+          blocks[*b].swap(rest);
+          if (in_work[*b]) {
+            work.push_back(z);
+            in_work[z] = 1;
+          } else {
+            int smaller = (blocks[z].size() < blocks[*b].size()) ? z : *b;
+            work.push_back(smaller);
+            in_work[smaller] = 1;
+          }
+        }
+        counts[*b] = 0;
+      }
+      for (auto s = x.begin(), s_end = x.end(); s != s_end; ++s) {
+        marked[*s] = 0;
+      }
+    }
+  }
+
+  if (blocks.size() - 1 == size_t(n) && size_t(n) == dfa_states.size()) {
+    return false;
+  }
+
+  // a block becomes a state at its first member in order of indices
+  std::vector<int> firsts;
+  for (size_t b = 0; b < blocks.size(); b++) {
+    if (blocks[b][0] != dead) {
+      firsts.push_back(*std::min_element(blocks[b].begin(), blocks[b].end()));
+    }
+  }
+  std::sort(firsts.begin(), firsts.end());
+  std::vector<int> new_index(blocks.size(), -1);
+  for (size_t i = 0; i < firsts.size(); i++) {
+    new_index[block_of[firsts[i]]] = static_cast<int>(i);
+  }
+
+  std::vector<DFAState> states(firsts.size());
+  for (size_t i = 0; i < firsts.size(); i++) {
+    const DFAState& s = dfa_states[order[firsts[i]]];
+    DFAState& o = states[i];
+    o.index = static_cast<int>(i);
+    o.accept_symbol = s.accept_symbol;
+    o.edges = s.edges;
+    for (auto j = o.edges.begin(), j_end = o.edges.end(); j != j_end; ++j) {
+      j->target = new_index[block_of[ids[j->target]]];
+    }
+  }
+  dfa_init = new_index[block_of[ids[dfa_init]]];
+  dfa_states.swap(states);
+  return true;
+}
+
+// removes charsets no edge uses and merges ones with the same ranges
+bool Grammar::PruneCharsets() {
+  std::vector<int> used(charsets.size(), 0);
+  for (auto i = dfa_states.begin(), i_end = dfa_states.end(); i != i_end; ++i) {
+    for (auto j = i->edges.begin(), j_end = i->edges.end(); j != j_end; ++j) {
+      used[j->charset] = 1;
+    }
+  }
+
+  typedef std::pair<int, std::vector<std::pair<uint16_t, uint16_t> > > Key;
+  std::map<Key, int> kept_by_ranges;
+  std::vector<int> new_index(charsets.size(), -1);
+  std::vector<CharacterSet> kept;
+  for (size_t i = 0; i < charsets.size(); i++) {
+    if (used[i] == 0) {
+      continue;
+    }
+    Key key(charsets[i].uniplane, charsets[i].ranges);
+    auto k = kept_by_ranges.find(key);
+    if (k != kept_by_ranges.end()) {
+      new_index[i] = k->second;
+      continue;
+    }
+    new_index[i] = static_cast<int>(kept.size());
+    kept_by_ranges.insert(std::make_pair(key, new_index[i]));
+    kept.push_back(charsets[i]);
+    kept.back().index = new_index[i];
+  }
+  if (kept.size() == charsets.size()) {
+    return false;
+  }
+
+  for (auto i = dfa_states.begin(), i_end = dfa_states.end(); i != i_end; ++i) {
+    for (auto j = i->edges.begin(), j_end = i->edges.end(); j != j_end; ++j) {
+      j->charset = new_index[j->charset];
+    }
+  }
+  charsets.swap(kept);
+  return true;
+}
+
+// removes LALR states which no shift or goto reaches from an initial state
+bool Grammar::PruneLALR() {
+  std::vector<int> new_index(lalr_states.size(), -1);
+  std::vector<int> left;
+  new_index[lalr_init] = 0;
+  left.push_back(lalr_init);
+  while (left.empty() == false) {
+    const LALRState& s = lalr_states[left.back()];
+    left.pop_back();
+    for (auto j = s.actions.begin(), j_end = s.actions.end(); j != j_end; ++j) {
+      const LALRAction& a = j->second;
+      if ((a.type == LALRActionType::kShift ||
+           a.type == LALRActionType::kGoto) && new_index[a.target] == -1) {
+        new_index[a.target] = 0;
+        left.push_back(a.target);
+      }
+    }
+  }
+
+  int count = 0;
+  for (size_t i = 0; i < new_index.size(); i++) {
+    if (new_index[i] != -1) {
+      new_index[i] = count++;
+    }
+  }
+  if (size_t(count) == lalr_states.size()) {
+    return false;
+  }
+
+  std::vector<LALRState> states(count);
+  for (size_t i = 0; i < lalr_states.size(); i++) {
+    if (new_index[i] == -1) {
+      continue;
+    }
+    LALRState& o = states[new_index[i]];
+    o.index = new_index[i];
+    o.actions.swap(lalr_states[i].actions);
+    for (auto j = o.actions.begin(), j_end = o.actions.end(); j != j_end; ++j) {
+      LALRAction& a = j->second;
+      if (a.type == LALRActionType::kShift ||
+          a.type == LALRActionType::kGoto) {
+        a.target = new_index[a.target];
+      }
+    }
+  }
+  lalr_init = new_index[lalr_init];
+  lalr_states.swap(states);
+  return true;
+}
+
+void Grammar::SetMinimize(bool minimize) {
+  minimize_ = minimize;
+}
+
+const MinimizeStats& Grammar::GetMinimizeStats() const {
+  return minimize_stats_;
+}
+
+}  // namespace cppauparser
@@ -0,0 +1,361 @@
+// Copyright 2012 Esun Kim
+
+#include "parallel.h"
+#include <algorithm>
+#include <thread>
+
+namespace cppauparser {
+
+struct ParallelParser::Worker {
+  Parser parser;
+  TreeBuilder builder;
+
+ public:
+  explicit Worker(const Grammar& grammar)
+      : parser(grammar) {
+  }
+};
+
+ParallelParser::ParallelParser(const Grammar& grammar)
+    : grammar_(grammar),
+      parser_(grammar),
+      scanner_(grammar),
+      nesting_(grammar.symbols.size(), 0),
+      chunk_size_(1 << 20),
+      thread_count_(0),
+      threads_(1),
+      buf_(NULL_PTR),
+      size_(0),
+      split_count_(0),
+      scan_until_(0),
+      next_chunk_(0),
+      failed_(false) {
+}
+
+ParallelParser::~ParallelParser() {
+}
+
+bool ParallelParser::SetList(const char* symbol_id,
+                             const char* separator_id) {
+  const Symbol* symbol = grammar_.GetSymbol(symbol_id);
+  const Symbol* separator = grammar_.GetSymbol(separator_id);
+  if (symbol == NULL_PTR || symbol->type != SymbolType::kNonTerminal ||
+      separator == NULL_PTR || separator->type != SymbolType::kTerminal) {
+    return false;
+  }
+
+  for (auto i = grammar_.productions.begin(),
+            i_end = grammar_.productions.end();
+       i != i_end; ++i) {
+    if (i->head != symbol->index || i->handles.size() < 2 ||
+        i->handles[0] != symbol->index) {
+      continue;
+    }
+    if (i->handles[1] == separator->index ||
+        i->handles.back() == separator->index) {
+      List list = { symbol, &*i, separator->index,
+                    i->handles[1] != separator->index };
+      lists_.push_back(list);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ParallelParser::AddNesting(const char* open_id, const char* close_id) {
+  const Symbol* open = grammar_.GetSymbol(open_id);
+  const Symbol* close = grammar_.GetSymbol(close_id);
+  if (open == NULL_PTR || close == NULL_PTR || open == close ||
+      nesting_[open->index] != 0 || nesting_[close->index] != 0) {
+    return false;
+  }
+  nesting_[open->index] = 1;
+  nesting_[close->index] = -1;
+  return true;
+}
+
+void ParallelParser::SetChunkSize(size_t size) {
+  chunk_size_ = std::max(size, size_t(1));
+}
+
+void ParallelParser::SetThreadCount(size_t count) {
+  thread_count_ = count;
+}
+
+bool ParallelParser::Parse(const byte* buf, size_t size) {
+  buf_ = buf;
+  size_ = size;
+  split_count_ = 0;
+  scan_until_ = 0;
+  threads_ = thread_count_ ? thread_count_
+                           : std::thread::hardware_concurrency();
+  builder_.result = NULL_PTR;
+  builder_.allocator.Clear();
+  parser_.LoadBuffer(buf, size);
+  scanner_.LoadBuffer(buf, size);
+
+  while (true) {
+    if (threads_ > 1 && lists_.empty() == false) {
+      const Token& t = parser_.ReadLookahead();
+      if (t.symbol->type != SymbolType::kEndOfFile &&
+          static_cast<size_t>(t.lexeme.c_str() - buf_) >= scan_until_) {
+        const LALRState* state = parser_.GetState();
+        bool split = false;
+        for (auto i = lists_.begin(), i_end = lists_.end();
+             i != i_end && split == false; ++i) {
+          const LALRAction* a = state->jmp_table[i->symbol->index];
+          split = (a != NULL_PTR && a->type == LALRActionType::kGoto &&
+                   Split(*i, t));
+        }
+        if (split) {
+          continue;
+        }
+      }
+    }
+
+    ParseResultType::T ret = parser_.ParseStep();
+    builder_(ret, parser_);
+    if (ret == ParseResultType::kAccept) {
+      return true;
+    } else if (ret == ParseResultType::kError) {
+      return false;
+    }
+  }
+}
+
+TreeNode* ParallelParser::GetResult() const {
+  return builder_.result;
+}
+
+const ParseErrorInfo& ParallelParser::GetErrorInfo() const {
+  return parser_.GetErrorInfo();
+}
+
+size_t ParallelParser::GetSplitCount() const {
+  return split_count_;
+}
+
+bool ParallelParser::Split(const List& list, const Token& token) {
+  const LALRState* state = parser_.GetState();
+  size_t begin = token.lexeme.c_str() - buf_;
+
+  // scan symbols up to an end of a list and find separators out of nesting
+  separators_.clear();
+  scanner_.Seek(begin, token.position);
+  size_t end;
+  int depth = 0;
+  while (true) {
+    size_t offset;
+    const Symbol* symbol = scanner_.ReadSymbol(&offset);
+    int nesting = nesting_[symbol->index];
+    if (nesting > 0) {
+      depth += 1;
+    } else if (nesting < 0) {
+      if (depth == 0) {
+        end = offset;
+        break;
+      }
+      depth -= 1;
+    } else if (symbol->index == list.separator) {
+      if (depth == 0) {
+        separators_.push_back(std::make_pair(offset, scanner_.GetOffset()));
+      }
+    } else if (symbol->type == SymbolType::kEndOfFile) {
+      end = offset;
+      break;
+    } else if (symbol->type == SymbolType::kError) {
+      // let a parser meet an error itself
+      scan_until_ = std::max(offset, begin + 1);
+      return false;
+    }
+  }
+
+  // a short list has only short lists in it. a long one can have
+  // a long list in it when it doesn't have enough separators.
+  size_t chunk_count = (end - begin) / chunk_size_;
+  scan_until_ = (chunk_count < 2) ? std::max(end, begin + 1) : begin + 1;
+
+  // cut at separators close to even offsets. a terminated list ends with
+  // a last separator.
+  chunks_.clear();
+  Chunk c;
+  c.offset = begin;
+  c.position = token.position;
+  c.result = NULL_PTR;
+  size_t cut_count = separators_.size() - (list.terminated ? 1 : 0);
+  size_t s = 0;
+  for (size_t k = 1; k < chunk_count; k++) {
+    size_t target = begin + (end - begin) / chunk_count * k;
+    while (s < cut_count && separators_[s].first < target) {
+      s += 1;
+    }
+    if (s == cut_count) {
+      break;
+    }
+    c.end = list.terminated ? separators_[s].second : separators_[s].first;
+    chunks_.push_back(c);
+    c.offset = separators_[s].second;
+    s += 1;
+  }
+  c.end = end;
+  chunks_.push_back(c);
+  if (chunks_.size() < 2) {
+    return false;
+  }
+
+  for (size_t i = 1, i_end = chunks_.size(); i < i_end; i++) {
+    const Chunk& prev = chunks_[i - 1];
+    chunks_[i].position = Lexer::AdvancePosition(
+        prev.position, buf_ + prev.offset, chunks_[i].offset - prev.offset);
+  }
+  const Chunk& last = chunks_.back();
+  std::pair<int, int> end_position = Lexer::AdvancePosition(
+      last.position, buf_ + last.offset, end - last.offset);
+
+  // parse chunks. a calling thread is one of workers.
+  size_t thread_count = std::min(threads_, chunks_.size());
+  while (workers_.size() < thread_count) {
+    workers_.push_back(std::unique_ptr<Worker>(new Worker(grammar_)));
+  }
+  next_chunk_ = 0;
+  failed_ = false;
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < thread_count; i++) {
+    threads.push_back(std::thread(&ParallelParser::RunWorker, this,
+                                  workers_[i].get(), &list, state));
+  }
+  RunWorker(workers_[0].get(), &list, state);
+  for (auto i = threads.begin(), i_end = threads.end(); i != i_end; ++i) {
+    i->join();
+  }
+
+  TreeNodeNonTerminal* node = failed_ ? NULL_PTR : Stitch(list);
+  if (node == NULL_PTR) {
+    for (size_t i = 0; i < thread_count; i++) {
+      workers_[i]->builder.allocator.Clear();
+    }
+    scan_until_ = std::max(end, begin + 1);
+    return false;
+  }
+
+  for (size_t i = 0; i < thread_count; i++) {
+    builder_.allocator.Merge(workers_[i]->builder.allocator);
+  }
+  if (parser_.ShiftSubtree(node->production, node, end, end_position) ==
+      false) {
+    return false;
+  }
+  split_count_ += 1;
+  return true;
+}
+
+void ParallelParser::RunWorker(Worker* worker, const List* list,
+                               const LALRState* state) {
+  worker->parser.LoadBuffer(buf_, size_);
+  while (failed_ == false) {
+    size_t i = next_chunk_.fetch_add(1);
+    if (i >= chunks_.size()) {
+      break;
+    }
+    if (RunChunk(worker, *list, state, &chunks_[i]) == false) {
+      failed_ = true;
+    }
+  }
+}
+
+bool ParallelParser::RunChunk(Worker* worker, const List& list,
+                              const LALRState* state, Chunk* chunk) {
+  // a chunk is done when a list symbol is reduced right above a state
+  // and a lookahead is at an end of a chunk.
+  Parser& parser = worker->parser;
+  parser.ResetCursor(state, chunk->offset, chunk->position);
+
+  // an empty chunk (e.g. after a trailing separator) would let a parser
+  // reduce items below a state where a list begins.
+  const Token& first = parser.ReadLookahead();
+  if (first.symbol->type == SymbolType::kEndOfFile ||
+      static_cast<size_t>(first.lexeme.c_str() - buf_) >= chunk->end) {
+    return false;
+  }
+
+  while (failed_ == false) {
+    ParseResultType::T ret = parser.ParseStep();
+    worker->builder(ret, parser);
+    if (ret == ParseResultType::kReduce) {
+      if (parser.GetStack().size() == 2 &&
+          parser.GetReduction().production->head == list.symbol->index) {
+        const Token& t = parser.ReadLookahead();
+        if (t.symbol->type == SymbolType::kEndOfFile ||
+            static_cast<size_t>(t.lexeme.c_str() - buf_) >= chunk->end) {
+          chunk->result = reinterpret_cast<TreeNode*>(parser.GetTop().data);
+          chunk->separator = t;
+          return true;
+        }
+      }
+    } else if (ret == ParseResultType::kAccept ||
+               ret == ParseResultType::kError) {
+      return false;
+    }
+  }
+  return false;
+}
+
+TreeNodeNonTerminal* ParallelParser::Stitch(const List& list) {
+  // a chunk is a left recursive tree of its own and its first item is
+  // reduced by a production which begins a list. that node is replaced
+  // with a node of list.production over a tree of previous chunks, so that
+  // a tree is the same as one of a single parser. NULL when productions of
+  // a list don't fit it and a list should be parsed on a calling thread.
+  const Production* lp = list.production;
+  size_t skip = list.terminated ? 1 : 2;
+  TreeNodeNonTerminal* tree =
+      static_cast<TreeNodeNonTerminal*>(chunks_[0].result);
+  for (size_t i = 1, i_end = chunks_.size(); i < i_end; i++) {
+    // walk down a spine to a node which begins a list
+    TreeNodeNonTerminal* parent = NULL_PTR;
+    TreeNodeNonTerminal* nt =
+        static_cast<TreeNodeNonTerminal*>(chunks_[i].result);
+    while (true) {
+      const Production* p = nt->production;
+      if (p->head != list.symbol->index || p->handles.empty() ||
+          p->handles[0] != list.symbol->index) {
+        break;
+      }
+      parent = nt;
+      nt = static_cast<TreeNodeNonTerminal*>(nt->childs[0]);
+    }
+
+    const Production* bp = nt->production;
+    if (list.terminated && bp->handles.empty() && parent != NULL_PTR) {
+      // an empty list is where previous chunks go
+      parent->childs[0] = tree;
+      tree = static_cast<TreeNodeNonTerminal*>(chunks_[i].result);
+      continue;
+    }
+    if (bp->handles.size() + skip != lp->handles.size() ||
+        std::equal(bp->handles.begin(), bp->handles.end(),
+                   lp->handles.begin() + skip) == false) {
+      return NULL_PTR;
+    }
+
+    TreeNodeNonTerminal* node = builder_.allocator.Create(
+        lp, static_cast<int>(lp->handles.size()));
+    int j = 0;
+    node->childs[j++] = tree;
+    if (list.terminated == false) {
+      node->childs[j++] = builder_.allocator.Create(chunks_[i - 1].separator);
+    }
+    for (int k = 0; k < nt->child_count; k++) {
+      node->childs[j++] = nt->childs[k];
+    }
+    if (parent != NULL_PTR) {
+      parent->childs[0] = node;
+      tree = static_cast<TreeNodeNonTerminal*>(chunks_[i].result);
+    } else {
+      tree = node;
+    }
+  }
+  return tree;
+}
+
+}  // namespace cppauparser
@@ -1,11 +1,43 @@
 // Copyright 2012 Esun Kim
 
 #include "parser.h"
+#include "budget.h"
+#include "pipeline.h"
 #include <vector>
 #include <utility>
+#include <algorithm>
 
 namespace cppauparser {
 
+ParseMemory::ParseMemory(void* buf, size_t size)
+    : buf_(static_cast<byte*>(buf)),
+      size_(size),
+      used_(0) {
+}
+
+void* ParseMemory::Allocate(size_t size) {
+  uintptr_t base = reinterpret_cast<uintptr_t>(buf_);
+  size_t offset = static_cast<size_t>(
+      ((base + used_ + 15) & ~static_cast<uintptr_t>(15)) - base);
+  if (offset > size_ || size > size_ - offset) {
+    return NULL_PTR;
+  }
+  used_ = offset + size;
+  return buf_ + offset;
+}
+
+void ParseMemory::Reset(size_t used) {
+  used_ = std::min(used, used_);
+}
+
+size_t ParseMemory::GetUsedBytes() const {
+  return used_;
+}
+
+size_t ParseMemory::GetFreeBytes() const {
+  return size_ - used_;
+}
+
 utf8_string ParseItem::GetString() const {
   if (production) {
     return utf8_format("S=%d, P=%s", state->index,
@@ -77,43 +109,163 @@ utf8_string ParseErrorInfo::GetString() const {
     return utf8_format("InternalError(%d:%d) State=%d",
         token.position.first, token.position.second,
         state->index);
+
+  case ParseErrorType::kCancelled:
+    return utf8_format("Cancelled(%d:%d)",
+        position.first, position.second);
+
+  case ParseErrorType::kOutOfMemory:
+    return utf8_format("OutOfMemory(%d:%d)",
+        position.first, position.second);
+
+  case ParseErrorType::kLimitExceeded:
+    return utf8_format("LimitExceeded(%d:%d)",
+        position.first, position.second);
   }
 
   return utf8_string();
 }
 
+CancellationToken::CancellationToken()
+    : cancelled_(false) {
+}
+
+void CancellationToken::Cancel() {
+  cancelled_.store(true, std::memory_order_relaxed);
+}
+
+void CancellationToken::Reset() {
+  cancelled_.store(false, std::memory_order_relaxed);
+}
+
+bool CancellationToken::IsCancelled() const {
+  return cancelled_.load(std::memory_order_relaxed);
+}
+
+ParseBudget::ParseBudget()
+    : max_steps(static_cast<size_t>(-1)),
+      deadline(Clock::time_point::max()),
+      cancellation(NULL_PTR) {
+}
+
+ParseBudget::ParseBudget(size_t max_steps)
+    : max_steps(max_steps),
+      deadline(Clock::time_point::max()),
+      cancellation(NULL_PTR) {
+}
+
+ParseBudget::ParseBudget(Clock::time_point deadline)
+    : max_steps(static_cast<size_t>(-1)),
+      deadline(deadline),
+      cancellation(NULL_PTR) {
+}
+
+ParseBudget::ParseBudget(size_t max_steps, Clock::time_point deadline,
+                         const CancellationToken* cancellation)
+    : max_steps(max_steps),
+      deadline(deadline),
+      cancellation(cancellation) {
+}
+
+ParseLimits::ParseLimits()
+    : max_depth(0),
+      max_tokens(0),
+      max_lexeme(0),
+      max_tree_bytes(0) {
+}
+
+ParseCheckpoint::ParseCheckpoint()
+    : shared_(0),
+      depth_(0),
+      state_(NULL_PTR),
+      token_used_(true) {
+}
+
+size_t ParseCheckpoint::GetOffset() const {
+  return lexer_.offset;
+}
+
+std::pair<int, int> ParseCheckpoint::GetPosition() const {
+  return lexer_.position;
+}
+
+size_t ParseCheckpoint::GetDepth() const {
+  return depth_;
+}
+
 Parser::Parser(const Grammar& grammar)
     : grammar_(grammar)
     , lexer_(grammar)
-    , trim_reduction_(false) {
+    , pipeline_(NULL_PTR)
+    , memory_(NULL_PTR)
+    , trim_reduction_(false)
+    , abort_(ParseErrorType::kNone)
+    , token_count_(0)
+    , stack_low_(0)
+    , checkpoint_interval_(0)
+    , checkpoint_countdown_(0) {
+  SetLimits(ParseLimits());
+}
+
+Parser::Parser(const Grammar& grammar, ParseMemory* memory, size_t max_depth)
+    : grammar_(grammar)
+    , lexer_(grammar)
+    , pipeline_(NULL_PTR)
+    , memory_(memory)
+    , trim_reduction_(false)
+    , abort_(ParseErrorType::kNone)
+    , token_count_(0)
+    , stack_(ParseAllocator<ParseItem>(memory))
+    , reduction_handles_(ParseAllocator<ParseItem>(memory))
+    , stack_low_(0)
+    , checkpoint_interval_(0)
+    , checkpoint_countdown_(0) {
+  // a stack and reduction handles take the same size. 32 is for alignment.
+  // a region which can't hold even a bottom of a stack is not touched and
+  // every load fails with kOutOfMemory.
+  size_t free_bytes = memory->GetFreeBytes();
+  size_t fit = (free_bytes > 32)
+               ? (free_bytes - 32) / (sizeof(ParseItem) * 2) : 0;
+  size_t depth = std::min(max_depth, fit);
+  if (depth > 0) {
+    stack_.reserve(depth);
+    reduction_handles_.reserve(depth);
+  }
+  SetLimits(ParseLimits());
 }
 
 Parser::~Parser() {
 }
 
 bool Parser::LoadFile(const PATHCHAR* file_path) {
+  pipeline_ = NULL_PTR;
   if (lexer_.LoadFile(file_path)) {
-    ResetState();
-    return true;
+    return ResetState();
   } else {
+    // nothing was parsed. an error of a last parse is not for this one.
+    error_info_ = ParseErrorInfo();
     return false;
   }
 }
 
 bool Parser::LoadString(const char* buf) {
+  pipeline_ = NULL_PTR;
   if (lexer_.LoadString(buf)) {
-    ResetState();
-    return true;
+    return ResetState();
   } else {
+    // nothing was parsed. an error of a last parse is not for this one.
+    error_info_ = ParseErrorInfo();
     return false;
   }
 }
 
 bool Parser::LoadBuffer(const byte* buf, size_t size) {
+  pipeline_ = NULL_PTR;
   if (lexer_.LoadBuffer(buf, size)) {
-    ResetState();
-    return true;
+    return ResetState();
   } else {
+    // nothing was parsed. an error of a last parse is not for this one.
+    error_info_ = ParseErrorInfo();
     return false;
   }
 }
@@ -123,44 +275,86 @@ void Parser::ResetCursor() {
   ResetState();
 }
 
+void Parser::ResetCursor(const LALRState* state, size_t offset,
+                         std::pair<int, int> position) {
+  lexer_.Seek(offset, position);
+  if (ResetState()) {
+    state_ = state;
+    stack_.back().state = state;
+  }
+}
+
+bool Parser::LoadPipeline(TokenPipeline* pipeline) {
+  lexer_.Unload();
+  pipeline_ = pipeline;
+  return ResetState();
+}
+
 std::shared_ptr<LexerBuffer> Parser::ReleaseBuffer() {
+  if (pipeline_) {
+    return pipeline_->ReleaseBuffer();
+  }
   return lexer_.ReleaseBuffer();
 }
 
+bool Parser::LoadStream() {
+  pipeline_ = NULL_PTR;
+  if (lexer_.LoadStream()) {
+    return ResetState();
+  } else {
+    // nothing was parsed. an error of a last parse is not for this one.
+    error_info_ = ParseErrorInfo();
+    return false;
+  }
+}
+
+ParseResultType::T Parser::Feed(const byte* buf, size_t size) {
+  FeedLexer(buf, size);
+  return ParseAll();
+}
+
+ParseResultType::T Parser::Finish() {
+  lexer_.Finish();
+  return ParseAll();
+}
+
+void Parser::FeedLexer(const byte* buf, size_t size) {
+  if (lexer_.IsStreamOpen() == false) {
+    LoadStream();
+  }
+  lexer_.Feed(buf, size);
+}
+
 ParseResultType::T Parser::ParseStep() {
+  return grammar_.IsLALRDirect() ? ParseStepIn<true>() : ParseStepIn<false>();
+}
+
+template<bool kDirect>
+ParseResultType::T Parser::ParseStepIn() {
   if (token_used_) {
-    ReadToken(&token_);
-    token_used_ = false;
+    ParseResultType::T ret;
+    if (ReadNextToken(&ret) == false) {
+      return ret;
+    }
   }
 
   if (token_.symbol->type == SymbolType::kError) {
-    error_info_ = ParseErrorInfo(ParseErrorType::kLexicalError,
-                                 GetPosition(), state_, token_);
-    return ParseResultType::kError;
+    return Fail(ParseErrorType::kLexicalError);
   }
 
   const LALRAction* fa = state_->jmp_table[token_.symbol->index];
   if (fa == NULL_PTR) {
-    error_info_ = ParseErrorInfo(ParseErrorType::kSyntaxError,
-                                 GetPosition(), state_, token_);
-    for (auto i = state_->actions.begin(),
-              i_end = state_->actions.end();
-         i != i_end; i++) {
-      const Symbol& symbol = grammar_.symbols[i->first];
-      if (symbol.type == SymbolType::kTerminal ||
-          symbol.type == SymbolType::kEndOfFile ||
-          symbol.type == SymbolType::kGroupStart ||
-          symbol.type == SymbolType::kGroupEnd) {
-        error_info_.expected_symbols.push_back(&symbol);
-      }
-    }
-    return ParseResultType::kError;
+    return Fail(ParseErrorType::kSyntaxError);
   }
 
   const LALRAction& action = *fa;
   if (action.type == LALRActionType::kShift) {
     // Shift
-    state_ = &grammar_.lalr_states[action.target];
+    if (stack_.size() >= stack_limit_) {
+      return FailDepth();
+    }
+    state_ = kDirect ? &grammar_.lalr_states[action.target]
+                     : grammar_.GetLALRState(action.target);
     ParseItem item = { state_, NULL_PTR, token_, NULL_PTR };
     stack_.push_back(item);
     token_used_ = true;
@@ -175,10 +369,12 @@ ParseResultType::T Parser::ParseStep() {
     const LALRState* top_state;
     if (trimmed) {
       top_state = stack_[stack_.size() - 2].state;
+      stack_low_ = std::min(stack_low_, stack_.size() - 1);
     } else {
       reduction_handles_.assign(stack_.end() - production.handles.size(),
                                 stack_.end());
       stack_.resize(stack_.size() - production.handles.size());
+      stack_low_ = std::min(stack_low_, stack_.size());
       top_state = stack_.back().state;
 
       reduction_.production = &production;
@@ -187,21 +383,21 @@ ParseResultType::T Parser::ParseStep() {
     // Reduce/Goto
     const LALRAction* ga = top_state->jmp_table[production.head];
     if (ga == NULL_PTR) {
-      error_info_ = ParseErrorInfo(ParseErrorType::kInternalError,
-                                   GetPosition(), state_, token_);
-      return ParseResultType::kError;
+      return Fail(ParseErrorType::kInternalError);
     }
     const LALRAction& goto_action = *ga;
     if (goto_action.type != LALRActionType::kGoto) {
-      error_info_ = ParseErrorInfo(ParseErrorType::kInternalError,
-                                   GetPosition(), state_, token_);
-      return ParseResultType::kError;
+      return Fail(ParseErrorType::kInternalError);
     }
-    state_ = &grammar_.lalr_states[goto_action.target];
+    state_ = kDirect ? &grammar_.lalr_states[goto_action.target]
+                     : grammar_.GetLALRState(goto_action.target);
     if (trimmed) {
       stack_.back().state = state_;
       return ParseResultType::kReduceEliminated;
     } else {
+      if (stack_.size() >= stack_limit_) {
+        return FailDepth();
+      }
       ParseItem item = { state_, &production, Token(), NULL_PTR };
       stack_.push_back(item);
       reduction_.head = &stack_.back();
@@ -209,17 +405,13 @@ ParseResultType::T Parser::ParseStep() {
     }
   } else if (action.type == LALRActionType::kGoto) {
     // Goto
-    error_info_ = ParseErrorInfo(ParseErrorType::kInternalError,
-                                 GetPosition(), state_, token_);
-    return ParseResultType::kError;
+    return Fail(ParseErrorType::kInternalError);
   } else if (action.type == LALRActionType::kAccept) {
     // Accept
     return ParseResultType::kAccept;
   } else {
     // Internal Error
-    error_info_ = ParseErrorInfo(ParseErrorType::kInternalError,
-                                 GetPosition(), state_, token_);
-    return ParseResultType::kError;
+    return Fail(ParseErrorType::kInternalError);
   }
 }
 
@@ -228,7 +420,8 @@ ParseResultType::T Parser::ParseReduce() {
     ParseResultType::T ret = ParseStep();
     if (ret == ParseResultType::kAccept ||
         ret == ParseResultType::kReduce ||
-        ret == ParseResultType::kError) {
+        ret == ParseResultType::kError ||
+        ret == ParseResultType::kNeedMoreInput) {
       return ret;
     }
   }
@@ -238,25 +431,263 @@ ParseResultType::T Parser::ParseAll() {
   while (true) {
     ParseResultType::T ret = ParseStep();
     if (ret == ParseResultType::kAccept ||
-        ret == ParseResultType::kError) {
+        ret == ParseResultType::kError ||
+        ret == ParseResultType::kNeedMoreInput) {
       return ret;
     }
   }
 }
 
-void Parser::ResetState() {
-  state_ = &grammar_.lalr_states[grammar_.lalr_init];
+ParseResultType::T Parser::ParseFor(const ParseBudget& budget) {
+  for (size_t steps = 0; ; ++steps) {
+    ParseResultType::T ret =
+        (steps % ParseBudget::kPollInterval != 0 && steps != budget.max_steps)
+        ? ParseStep() : ParseStepWithin(budget, steps);
+    if (ret == ParseResultType::kAccept ||
+        ret == ParseResultType::kError ||
+        ret == ParseResultType::kNeedMoreInput ||
+        ret == ParseResultType::kSuspended) {
+      return ret;
+    }
+  }
+}
+
+bool Parser::CanAccept() {
+  // reduce on an end of a text over a stack without changing it
+  std::vector<const LALRState*>& pushed = state_stack_;
+  pushed.clear();
+  size_t depth = stack_.size();
+  const LALRState* state = state_;
+  while (true) {
+    const LALRAction* fa = state->jmp_table[grammar_.symbol_EOF->index];
+    if (fa == NULL_PTR) {
+      return false;
+    } else if (fa->type == LALRActionType::kAccept) {
+      return true;
+    } else if (fa->type != LALRActionType::kReduce) {
+      return false;
+    }
+    const Production& production = grammar_.productions[fa->target];
+    size_t n = production.handles.size();
+    size_t n_pushed = std::min(n, pushed.size());
+    pushed.resize(pushed.size() - n_pushed);
+    depth -= n - n_pushed;
+    const LALRState* top = pushed.empty() ? stack_[depth - 1].state
+                                          : pushed.back();
+    const LALRAction* ga = top->jmp_table[production.head];
+    if (ga == NULL_PTR || ga->type != LALRActionType::kGoto) {
+      return false;
+    }
+    state = grammar_.GetLALRState(ga->target);
+    pushed.push_back(state);
+  }
+}
+
+bool Parser::EndRecord(Token* next) {
+  if (error_info_.type != ParseErrorType::kSyntaxError ||
+      token_.symbol->type == SymbolType::kEndOfFile ||
+      CanAccept() == false) {
+    return false;
+  }
+  // a lookahead begins a next record. an end of a text takes its place.
+  *next = token_;
+  token_ = Token(grammar_.symbol_EOF,
+                 utf8_substring(token_.lexeme.c_str(), 0), token_.position);
+  token_used_ = false;
+  error_info_.type = ParseErrorType::kNone;
+  error_info_.expected_symbols.clear();
+  return true;
+}
+
+void Parser::NextRecord(const Token& next) {
+  // a lexer is right after a first token of a next record
+  ResetCursor(grammar_.GetLALRState(grammar_.lalr_init),
+              lexer_.GetOffset(), lexer_.GetPosition());
+  token_ = next;
+  token_used_ = false;
+}
+
+void Parser::SkipRecord(const Token& begin) {
+  const utf8_substring text = lexer_.GetText();
+  const byte* text_end = text.c_str() + text.size();
+  const byte* error = error_info_.token.lexeme.c_str();
+  if (error_info_.token.symbol == NULL_PTR ||
+      error_info_.token.symbol->type == SymbolType::kEndOfFile ||
+      error < begin.lexeme.c_str() || error > text_end) {
+    error = text_end;
+  }
+
+  // a line of an error can begin a next record when a failed one
+  // started before it. otherwise go on from a next line.
+  const byte* cur = error;
+  std::pair<int, int> position;
+  while (cur > begin.lexeme.c_str() && cur[-1] != '\n') {
+    cur -= 1;
+  }
+  if (cur > begin.lexeme.c_str()) {
+    position = Lexer::AdvancePosition(begin.position, begin.lexeme.c_str(),
+                                      cur - begin.lexeme.c_str());
+  } else {
+    cur = error;
+    while (cur < text_end && *cur != '\n') {
+      cur += 1;
+    }
+    if (cur < text_end) {
+      cur += 1;
+    }
+    position = Lexer::AdvancePosition(error_info_.token.position, error,
+                                      cur - error);
+  }
+  ResetCursor(grammar_.GetLALRState(grammar_.lalr_init),
+              cur - text.c_str(), position);
+}
+
+bool Parser::Validate(const byte* buf, size_t size) {
+  if (LoadBuffer(buf, size) == false) {
+    return false;
+  }
+
+  // a stack of states is on a heap and not bound to a fixed memory
+  size_t depth_limit = limits_.max_depth ? limits_.max_depth
+                                         : static_cast<size_t>(-1);
+  const LALRState* state = state_;
+  state_stack_.clear();
+  state_stack_.push_back(state);
+  size_t offset;
+  const Symbol* symbol = lexer_.ReadSymbol(&offset);
+  bool goto_failed = false;
+  bool limited = false;
+  while (true) {
+    const LALRAction* fa = state->jmp_table[symbol->index];
+    if (fa == NULL_PTR || symbol->type == SymbolType::kError) {
+      break;
+    }
+    if (fa->type == LALRActionType::kShift) {
+      if (state_stack_.size() >= depth_limit ||
+          ++token_count_ > token_limit_) {
+        limited = true;
+        break;
+      }
+      state = grammar_.GetLALRState(fa->target);
+      state_stack_.push_back(state);
+      symbol = lexer_.ReadSymbol(&offset);
+    } else if (fa->type == LALRActionType::kReduce) {
+      const Production& production = grammar_.productions[fa->target];
+      state_stack_.resize(state_stack_.size() - production.handles.size());
+      if (state_stack_.size() >= depth_limit) {
+        limited = true;
+        break;
+      }
+      const LALRAction* ga = state_stack_.back()->jmp_table[production.head];
+      if (ga == NULL_PTR || ga->type != LALRActionType::kGoto) {
+        goto_failed = true;
+        break;
+      }
+      state = grammar_.GetLALRState(ga->target);
+      state_stack_.push_back(state);
+    } else if (fa->type == LALRActionType::kAccept) {
+      return true;
+    } else {
+      break;
+    }
+  }
+
+  // read a failed token again with a position and let ParseStep
+  // make an error report.
+  lexer_.Seek(offset, Lexer::AdvancePosition(std::make_pair(1, 1),
+                                             buf, offset));
+  state_ = state;
+  ReadToken(&token_);
+  token_used_ = false;
+  if (goto_failed) {
+    Fail(ParseErrorType::kInternalError);
+  } else if (limited) {
+    Fail(ParseErrorType::kLimitExceeded);
+  } else {
+    ParseStep();
+  }
+  return false;
+}
+
+ParseResultType::T Parser::ParseStepWithin(const ParseBudget& budget,
+                                           size_t steps) {
+  if (budget.cancellation && budget.cancellation->IsCancelled()) {
+    return Fail(ParseErrorType::kCancelled);
+  }
+  if (steps >= budget.max_steps) {
+    return ParseResultType::kSuspended;
+  }
+  if (budget.deadline != ParseBudget::Clock::time_point::max() &&
+      ParseBudget::Clock::now() >= budget.deadline) {
+    return ParseResultType::kSuspended;
+  }
+  return ParseStep();
+}
+
+ParseResultType::T Parser::Fail(ParseErrorType::T type) {
+  if (type == ParseErrorType::kSyntaxError &&
+      token_.symbol->type == SymbolType::kError) {
+    type = ParseErrorType::kLexicalError;
+  }
+  // filled in place to reuse a capacity of expected symbols
+  error_info_.type = type;
+  error_info_.position = GetPosition();
+  error_info_.state = state_;
+  error_info_.token = token_;
+  error_info_.expected_symbols.clear();
+  if (type == ParseErrorType::kSyntaxError && memory_ == NULL_PTR) {
+    for (auto i = state_->actions.begin(),
+              i_end = state_->actions.end();
+         i != i_end; i++) {
+      const Symbol& symbol = grammar_.symbols[i->first];
+      if (symbol.type == SymbolType::kTerminal ||
+          symbol.type == SymbolType::kEndOfFile ||
+          symbol.type == SymbolType::kGroupStart ||
+          symbol.type == SymbolType::kGroupEnd) {
+        error_info_.expected_symbols.push_back(&symbol);
+      }
+    }
+  }
+  return ParseResultType::kError;
+}
+
+bool Parser::ResetState() {
+  state_ = grammar_.GetLALRState(grammar_.lalr_init);
   token_ = Token();
   token_used_ = true;
-  ParseItem item = { state_, NULL_PTR, token_, NULL_PTR };
+  abort_ = ParseErrorType::kNone;
+  token_count_ = 0;
   stack_.clear();
+  last_checkpoint_.reset();
+  stack_low_ = 0;
+  checkpoint_countdown_ = checkpoint_interval_;
+  checkpoints_.clear();
+  if (stack_.capacity() == 0 && memory_) {
+    // a fixed memory too small for a stack
+    Fail(ParseErrorType::kOutOfMemory);
+    return false;
+  }
+  ParseItem item = { state_, NULL_PTR, token_, NULL_PTR };
   stack_.push_back(item);
+  return true;
+}
+
+ParseResultType::T Parser::FailDepth() {
+  if (limits_.max_depth != 0 && stack_.size() >= limits_.max_depth) {
+    return Fail(ParseErrorType::kLimitExceeded);
+  }
+  return Fail(ParseErrorType::kOutOfMemory);
 }
 
 void Parser::ReadToken(Token* token) {
+  if (pipeline_) {
+    pipeline_->ReadToken(token);
+    return;
+  }
   while (true) {
     lexer_.ReadToken(token);
-    if (token->symbol->type != SymbolType::kNoise) {
+    if (token->symbol == NULL_PTR ||
+        token->symbol->type != SymbolType::kNoise) {
       return;
     }
   }
@@ -270,7 +701,30 @@ const ParseItem& Parser::GetTop() const {
   return stack_.back();
 }
 
-const std::vector<ParseItem>& Parser::GetStack() const {
+void Parser::Abort(ParseErrorType::T type) const {
+  abort_ = type;
+}
+
+void Parser::SetLimits(const ParseLimits& limits) {
+  const size_t kNoLimit = static_cast<size_t>(-1);
+  limits_ = limits;
+  stack_limit_ = limits.max_depth ? limits.max_depth : kNoLimit;
+  if (memory_) {
+    stack_limit_ = std::min(stack_limit_, stack_.capacity());
+  }
+  token_limit_ = limits.max_tokens ? limits.max_tokens : kNoLimit;
+  lexeme_limit_ = limits.max_lexeme ? limits.max_lexeme : kNoLimit;
+}
+
+const ParseLimits& Parser::GetLimits() const {
+  return limits_;
+}
+
+size_t Parser::GetMaxDepth() const {
+  return stack_limit_;
+}
+
+const ParseItemVector& Parser::GetStack() const {
   return stack_;
 }
 
@@ -287,17 +741,143 @@ const ParseErrorInfo& Parser::GetErrorInfo() const {
 }
 
 int Parser::GetLine() const {
-  return lexer_.GetLine();
+  return GetPosition().first;
 }
 
 int Parser::GetColumn() const {
-  return lexer_.GetColumn();
+  return GetPosition().second;
 }
 
 std::pair<int, int> Parser::GetPosition() const {
+  if (pipeline_) {
+    return pipeline_->GetPosition();
+  }
   return lexer_.GetPosition();
 }
 
+const Lexer& Parser::GetLexer() const {
+  return lexer_;
+}
+
+const Grammar& Parser::GetGrammar() const {
+  return grammar_;
+}
+
+std::shared_ptr<const ParseCheckpoint> Parser::Snapshot() {
+  std::shared_ptr<ParseCheckpoint> c = std::make_shared<ParseCheckpoint>();
+
+  // skip ancestors which don't hold any item of a shared part
+  size_t shared = std::min(stack_low_, stack_.size());
+  std::shared_ptr<const ParseCheckpoint> parent = last_checkpoint_;
+  while (parent && shared > 0 && parent->shared_ >= shared) {
+    parent = parent->parent_;
+  }
+  if (parent == NULL_PTR) {
+    shared = 0;
+  }
+
+  c->parent_ = parent;
+  c->shared_ = shared;
+  c->tail_.assign(stack_.begin() + shared, stack_.end());
+  c->depth_ = stack_.size();
+  c->state_ = state_;
+  c->token_ = token_;
+  c->token_used_ = token_used_;
+  lexer_.SaveState(&c->lexer_);
+
+  last_checkpoint_ = c;
+  stack_low_ = stack_.size();
+  checkpoint_countdown_ = checkpoint_interval_;
+  return c;
+}
+
+bool Parser::Restore(const std::shared_ptr<const ParseCheckpoint>& checkpoint) {
+  if (checkpoint->depth_ > stack_.capacity() && memory_) {
+    return false;
+  }
+  if (lexer_.RestoreState(checkpoint->lexer_) == false) {
+    return false;
+  }
+
+  // fill a stack from the top with tails of a checkpoint and its ancestors
+  stack_.resize(checkpoint->depth_);
+  size_t filled = checkpoint->depth_;
+  for (const ParseCheckpoint* c = checkpoint.get();
+       c != NULL_PTR && filled > 0;
+       c = c->parent_.get()) {
+    if (c->shared_ < filled) {
+      std::copy(c->tail_.begin(), c->tail_.begin() + (filled - c->shared_),
+                stack_.begin() + c->shared_);
+      filled = c->shared_;
+    }
+  }
+
+  state_ = checkpoint->state_;
+  token_ = checkpoint->token_;
+  token_used_ = checkpoint->token_used_;
+
+  last_checkpoint_ = checkpoint;
+  stack_low_ = stack_.size();
+  checkpoint_countdown_ = checkpoint_interval_;
+  while (checkpoints_.empty() == false &&
+         checkpoints_.back()->GetOffset() > checkpoint->GetOffset()) {
+    checkpoints_.pop_back();
+  }
+  return true;
+}
+
+void Parser::SetCheckpointInterval(size_t tokens) {
+  checkpoint_interval_ = tokens;
+  checkpoint_countdown_ = tokens;
+}
+
+const std::vector<std::shared_ptr<const ParseCheckpoint>>&
+    Parser::GetCheckpoints() const {
+  return checkpoints_;
+}
+
+std::shared_ptr<const ParseCheckpoint> Parser::FindCheckpoint(
+    size_t offset) const {
+  auto i = std::upper_bound(
+      checkpoints_.begin(), checkpoints_.end(), offset,
+      [](size_t offset, const std::shared_ptr<const ParseCheckpoint>& c) {
+        return offset < c->GetOffset();
+      });
+  if (i == checkpoints_.begin()) {
+    return std::shared_ptr<const ParseCheckpoint>();
+  }
+  return *(i - 1);
+}
+
+const Token& Parser::ReadLookahead() {
+  if (token_used_) {
+    ReadToken(&token_);
+    token_used_ = (token_.symbol == NULL_PTR);
+  }
+  return token_;
+}
+
+bool Parser::ShiftSubtree(const Production* production, void* data,
+                          size_t end_offset, std::pair<int, int> end_position) {
+  const LALRAction* ga = state_->jmp_table[production->head];
+  if (ga == NULL_PTR || ga->type != LALRActionType::kGoto) {
+    return false;
+  }
+
+  if (stack_.size() >= stack_limit_) {
+    return false;
+  }
+
+  state_ = grammar_.GetLALRState(ga->target);
+  ParseItem item = { state_, production, Token(), data };
+  stack_.push_back(item);
+
+  // drop a lookahead which belonged to the subtree and continue after it
+  lexer_.Seek(end_offset, end_position);
+  token_used_ = true;
+  return true;
+}
+
 ProductionHandler::ProductionHandler(const Grammar& grammar)
   : grammar_(grammar),
     result_(NULL_PTR) {
@@ -0,0 +1,151 @@
+// Copyright 2012 Esun Kim
+
+#include "pipeline.h"
+
+namespace cppauparser {
+
+TokenPipeline::TokenPipeline(const Grammar& grammar,
+                             size_t capacity, size_t batch)
+    : grammar_(grammar),
+      lexer_(grammar),
+      mask_(0),
+      batch_(batch > 0 ? batch : 1),
+      stop_(false),
+      finished_(true),
+      head_(0),
+      tail_(0),
+      read_(0),
+      read_limit_(0),
+      read_published_(0),
+      position_(std::make_pair(0, 0)) {
+  size_t n = 2;
+  while (n < capacity || n < batch_ * 2) {
+    n *= 2;
+  }
+  ring_.resize(n);
+  mask_ = n - 1;
+}
+
+TokenPipeline::~TokenPipeline() {
+  Stop();
+}
+
+bool TokenPipeline::LoadFile(const PATHCHAR* file_path) {
+  Stop();
+  if (lexer_.LoadFile(file_path) == false) {
+    return false;
+  }
+  Start();
+  return true;
+}
+
+bool TokenPipeline::LoadString(const char* buf) {
+  Stop();
+  if (lexer_.LoadString(buf) == false) {
+    return false;
+  }
+  Start();
+  return true;
+}
+
+bool TokenPipeline::LoadBuffer(const byte* buf, size_t size) {
+  Stop();
+  if (lexer_.LoadBuffer(buf, size) == false) {
+    return false;
+  }
+  Start();
+  return true;
+}
+
+void TokenPipeline::Stop() {
+  stop_.store(true, std::memory_order_relaxed);
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+std::shared_ptr<LexerBuffer> TokenPipeline::ReleaseBuffer() {
+  Stop();
+  return lexer_.ReleaseBuffer();
+}
+
+void TokenPipeline::Start() {
+  head_.store(0, std::memory_order_relaxed);
+  tail_.store(0, std::memory_order_relaxed);
+  read_ = 0;
+  read_limit_ = 0;
+  read_published_ = 0;
+  last_token_ = Token(grammar_.symbol_EOF, utf8_substring(),
+                      lexer_.GetPosition());
+  position_ = lexer_.GetPosition();
+  stop_.store(false, std::memory_order_relaxed);
+  finished_.store(false, std::memory_order_relaxed);
+  thread_ = std::thread(&TokenPipeline::Run, this);
+}
+
+void TokenPipeline::Run() {
+  size_t write = 0;
+  size_t write_limit = ring_.size();
+  size_t write_published = 0;
+  while (stop_.load(std::memory_order_relaxed) == false) {
+    if (write == write_limit) {
+      // ring is full. publish what we have and see how far a parser read
+      if (write_published != write) {
+        write_published = write;
+        tail_.store(write, std::memory_order_release);
+      }
+      write_limit = head_.load(std::memory_order_acquire) + ring_.size();
+      if (write == write_limit) {
+        std::this_thread::yield();
+      }
+      continue;
+    }
+
+    Slot& slot = ring_[write & mask_];
+    do {
+      lexer_.ReadToken(&slot.token);
+    } while (slot.token.symbol->type == SymbolType::kNoise);
+    slot.position = lexer_.GetPosition();
+    write += 1;
+
+    // a parser stops at EOF or an error token, so does a lexer
+    bool last = slot.token.symbol->type == SymbolType::kEndOfFile ||
+                slot.token.symbol->type == SymbolType::kError;
+    if (last || write - write_published >= batch_) {
+      write_published = write;
+      tail_.store(write, std::memory_order_release);
+    }
+    if (last) {
+      break;
+    }
+  }
+  finished_.store(true, std::memory_order_release);
+}
+
+bool TokenPipeline::Wait() {
+  // let a producer reuse slots while we are waiting
+  if (read_published_ != read_) {
+    read_published_ = read_;
+    head_.store(read_, std::memory_order_release);
+  }
+
+  for (int spin = 0; ; spin++) {
+    bool finished = finished_.load(std::memory_order_acquire);
+    read_limit_ = tail_.load(std::memory_order_acquire);
+    if (read_ != read_limit_) {
+      return true;
+    }
+    if (finished) {
+      // nothing will come. repeat a last token. (normally EOF)
+      if (read_ > 0) {
+        last_token_ = ring_[(read_ - 1) & mask_].token;
+      }
+      return false;
+    }
+    if (spin >= 64) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+}  // namespace cppauparser
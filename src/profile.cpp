@@ -0,0 +1,178 @@
+// Copyright 2012 Esun Kim
+
+#include "grammar.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+namespace cppauparser {
+
+// a profile is a text file as following.
+//
+//   auparser-profile 1
+//   fingerprint <low> <high>
+//   dfa <count>
+//   <visits of each state>
+//   lalr <count>
+//   <visits of each state>
+
+static const int kProfileVersion = 1;
+
+static bool ReadVisits(FILE* fp, const char* name,
+                       std::vector<uint64_t>* visits) {
+  char label[16];
+  unsigned long long count;
+  if (fscanf(fp, "%15s %llu", label, &count) != 2 ||
+      strcmp(label, name) != 0 || count > 0x1000000) {
+    return false;
+  }
+  visits->resize(static_cast<size_t>(count));
+  for (size_t i = 0; i < visits->size(); i++) {
+    unsigned long long v;
+    if (fscanf(fp, "%llu", &v) != 1) {
+      return false;
+    }
+    (*visits)[i] = v;
+  }
+  return true;
+}
+
+static void WriteVisits(FILE* fp, const char* name,
+                        const std::vector<uint64_t>& visits) {
+  fprintf(fp, "%s %llu\n", name, (unsigned long long)visits.size());
+  for (size_t i = 0; i < visits.size(); i++) {
+    fprintf(fp, "%llu\n", (unsigned long long)visits[i]);
+  }
+}
+
+bool GrammarProfile::LoadFile(const PATHCHAR* file_path) {
+  FILE* fp = PATHOPEN(file_path, PATHSTR("r"));
+  if (fp == NULL) {
+    return false;
+  }
+
+  // a profile is changed only when a whole file is read
+  char magic[32];
+  int version;
+  char label[16];
+  unsigned long long low, high;
+  std::vector<uint64_t> dfa;
+  std::vector<uint64_t> lalr;
+  bool ret =
+      fscanf(fp, "%31s %d", magic, &version) == 2 &&
+      strcmp(magic, "auparser-profile") == 0 &&
+      version == kProfileVersion &&
+      fscanf(fp, "%15s %llx %llx", label, &low, &high) == 3 &&
+      strcmp(label, "fingerprint") == 0 &&
+      ReadVisits(fp, "dfa", &dfa) &&
+      ReadVisits(fp, "lalr", &lalr);
+  fclose(fp);
+
+  if (ret) {
+    fingerprint = Hash128(low, high);
+    dfa_visits.swap(dfa);
+    lalr_visits.swap(lalr);
+  }
+  return ret;
+}
+
+bool GrammarProfile::SaveFile(const PATHCHAR* file_path) const {
+  FILE* fp = PATHOPEN(file_path, PATHSTR("w"));
+  if (fp == NULL) {
+    return false;
+  }
+
+  fprintf(fp, "auparser-profile %d\n", kProfileVersion);
+  fprintf(fp, "fingerprint %016llx %016llx\n",
+          (unsigned long long)fingerprint.low,
+          (unsigned long long)fingerprint.high);
+  WriteVisits(fp, "dfa", dfa_visits);
+  WriteVisits(fp, "lalr", lalr_visits);
+  return fclose(fp) == 0;
+}
+
+void Grammar::SetProfiling(bool profiling) {
+  profiling_ = profiling;
+}
+
+void Grammar::SetLayoutProfile(const GrammarProfile& profile) {
+  layout_profile_ = profile;
+}
+
+bool Grammar::IsLayoutApplied() const {
+  return layout_applied_;
+}
+
+// indices of states from the hottest one. ties keep an order of indices.
+static void GetHotOrder(const std::vector<uint64_t>& visits,
+                        std::vector<int>* order,
+                        std::vector<int>* new_index) {
+  struct HotterThan {
+    const std::vector<uint64_t>* visits;
+    bool operator()(int a, int b) const {
+      return (*visits)[a] > (*visits)[b];
+    }
+  };
+  order->resize(visits.size());
+  for (size_t i = 0; i < visits.size(); i++) {
+    (*order)[i] = static_cast<int>(i);
+  }
+  HotterThan hotter = { &visits };
+  std::stable_sort(order->begin(), order->end(), hotter);
+  new_index->resize(visits.size());
+  for (size_t i = 0; i < order->size(); i++) {
+    (*new_index)[(*order)[i]] = static_cast<int>(i);
+  }
+}
+
+// states are copied to new tables from the hottest one, so that their
+// lookups are also allocated close together when they are built.
+bool Grammar::ApplyLayout() {
+  const GrammarProfile& p = layout_profile_;
+  if (p.fingerprint != fingerprint_ ||
+      p.dfa_visits.size() != dfa_states.size() ||
+      p.lalr_visits.size() != lalr_states.size() ||
+      dfa_states.empty() || lalr_states.empty()) {
+    return false;
+  }
+
+  std::vector<int> order;
+  std::vector<int> new_index;
+
+  GetHotOrder(p.dfa_visits, &order, &new_index);
+  std::vector<DFAState> dfa(dfa_states.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    DFAState& o = dfa[i];
+    o = dfa_states[order[i]];
+    o.index = static_cast<int>(i);
+    for (auto j = o.edges.begin(), j_end = o.edges.end(); j != j_end; ++j) {
+      j->target = new_index[j->target];
+    }
+  }
+  dfa_init = new_index[dfa_init];
+  dfa_states.swap(dfa);
+
+  GetHotOrder(p.lalr_visits, &order, &new_index);
+  std::vector<LALRState> lalr(lalr_states.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    LALRState& o = lalr[i];
+    o.index = static_cast<int>(i);
+    o.actions = lalr_states[order[i]].actions;
+    for (auto j = o.actions.begin(), j_end = o.actions.end(); j != j_end; ++j) {
+      LALRAction& a = j->second;
+      if (a.type == LALRActionType::kShift ||
+          a.type == LALRActionType::kGoto) {
+        a.target = new_index[a.target];
+      }
+    }
+  }
+  lalr_init = new_index[lalr_init];
+  lalr_states.swap(lalr);
+
+  // indices of states are not ones of a file any more
+  fingerprint_ = HashBytes(&fingerprint_, sizeof(fingerprint_), 2);
+  return true;
+}
+
+}  // namespace cppauparser
@@ -0,0 +1,71 @@
+// Copyright 2012 Esun Kim
+
+#include "tape.h"
+
+namespace cppauparser {
+
+ParseTape::ParseTape()
+    : accepted(false) {
+}
+
+void ParseTape::Clear() {
+  words.clear();
+  accepted = false;
+}
+
+size_t ParseTape::GetRoot() const {
+  return words.size() - kRecordSize;
+}
+
+TapeBuilder::TapeBuilder()
+    : base_(NULL_PTR) {
+}
+
+void TapeBuilder::Reset(const byte* base) {
+  base_ = base;
+  tape.Clear();
+  begins_.clear();
+  // a bottom item of a parser stack
+  begins_.push_back(0);
+}
+
+// offsets, sizes and indices of records are kept in 32-bit words
+static const uint64_t kMaxWord = 0xFFFFFFFF;
+
+void TapeBuilder::operator()(ParseResultType::T ret, const Parser& parser) {
+  std::vector<uint32_t>& words = tape.words;
+  if (words.size() > kMaxWord - ParseTape::kRecordSize &&
+      (ret == ParseResultType::kShift || ret == ParseResultType::kReduce)) {
+    parser.Abort(ParseErrorType::kLimitExceeded);
+    return;
+  }
+
+  if (ret == ParseResultType::kShift) {
+    const Token& token = parser.GetToken();
+    uint64_t offset = static_cast<uint64_t>(token.lexeme.c_str() - base_);
+    uint64_t size = token.lexeme.size();
+    if (offset > kMaxWord || size > kMaxWord - offset) {
+      parser.Abort(ParseErrorType::kLimitExceeded);
+      return;
+    }
+    uint32_t begin = static_cast<uint32_t>(words.size());
+    words.push_back(static_cast<uint32_t>(token.symbol->index) << 1);
+    words.push_back(static_cast<uint32_t>(offset));
+    words.push_back(static_cast<uint32_t>(size));
+    begins_.push_back(begin);
+  } else if (ret == ParseResultType::kReduce) {
+    const ParseReduction& r = parser.GetReduction();
+    size_t n = r.handles->size();
+    uint32_t end = static_cast<uint32_t>(words.size());
+    uint32_t begin = (n > 0) ? begins_[begins_.size() - n] : end;
+    words.push_back((static_cast<uint32_t>(r.production->index) << 1) | 1);
+    words.push_back(static_cast<uint32_t>(n));
+    words.push_back(end - begin);
+    begins_.resize(begins_.size() - n);
+    begins_.push_back(begin);
+  } else if (ret == ParseResultType::kAccept) {
+    tape.accepted = true;
+  }
+}
+
+}  // namespace cppauparser
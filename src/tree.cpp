@@ -54,8 +54,20 @@ size_t TreeNodeNonTerminal::CalculateObjectSize(int child_count) {
 
 TreeNodeAllocator::TreeNodeAllocator()
     : block_size_(4096),
+      next_block_(0),
       cur_(NULL_PTR),
-      cur_left_(0) {
+      cur_left_(0),
+      used_bytes_(0),
+      memory_(NULL_PTR) {
+}
+
+TreeNodeAllocator::TreeNodeAllocator(ParseMemory* memory)
+    : block_size_(4096),
+      next_block_(0),
+      cur_(NULL_PTR),
+      cur_left_(0),
+      used_bytes_(0),
+      memory_(memory) {
 }
 
 TreeNodeAllocator::~TreeNodeAllocator() {
@@ -63,10 +75,30 @@ TreeNodeAllocator::~TreeNodeAllocator() {
 }
 
 TreeNode* TreeNodeAllocator::Alloc(size_t size) {
+  if (memory_) {
+    void* ret = memory_->Allocate(size);
+    if (ret) {
+      used_bytes_ += size;
+    }
+    return reinterpret_cast<TreeNode*>(ret);
+  }
+
+  used_bytes_ += size;
+
+  if (size > block_size_) {
+    // a large node (e.g. a long list) gets a dedicated block
+    void* ret = malloc(size);
+    large_blocks_.push_back(ret);
+    return reinterpret_cast<TreeNode*>(ret);
+  }
+
   if (size > cur_left_) {
-    cur_ = malloc(block_size_);
+    if (next_block_ == blocks_.size()) {
+      blocks_.push_back(malloc(block_size_));
+    }
+    cur_ = blocks_[next_block_];
     cur_left_ = block_size_;
-    blocks_.push_back(cur_);
+    next_block_ += 1;
   }
 
   void* ret = cur_;
@@ -79,6 +111,9 @@ TreeNode* TreeNodeAllocator::Alloc(size_t size) {
 TreeNodeTerminal* TreeNodeAllocator::Create(const Token& token) {
   TreeNodeTerminal* n = static_cast<TreeNodeTerminal*>(
       Alloc(sizeof(TreeNodeTerminal)));
+  if (n == NULL_PTR) {
+    return NULL_PTR;
+  }
   new (n) TreeNodeTerminal(token);
   return n;
 }
@@ -87,62 +122,198 @@ TreeNodeNonTerminal* TreeNodeAllocator::Create(const Production* production,
                                                int child_count) {
   TreeNodeNonTerminal* n = static_cast<TreeNodeNonTerminal*>(
       Alloc(TreeNodeNonTerminal::CalculateObjectSize(child_count)));
+  if (n == NULL_PTR) {
+    return NULL_PTR;
+  }
   new (n) TreeNodeNonTerminal(production, child_count);
   return n;
 }
 
 void TreeNodeAllocator::Clear() {
+  Reset();
   for (auto i = blocks_.begin(), i_end = blocks_.end(); i != i_end; ++i)
     free(*i);
+  blocks_.clear();
+}
+
+void TreeNodeAllocator::Reset() {
+  for (auto i = large_blocks_.begin(), i_end = large_blocks_.end();
+       i != i_end; ++i)
+    free(*i);
+  large_blocks_.clear();
+  next_block_ = 0;
   cur_ = NULL_PTR;
   cur_left_ = 0;
+  used_bytes_ = 0;
 }
 
 void TreeNodeAllocator::Swap(TreeNodeAllocator& a) {
   std::swap(block_size_, a.block_size_);
   std::swap(blocks_, a.blocks_);
+  std::swap(next_block_, a.next_block_);
+  std::swap(large_blocks_, a.large_blocks_);
   std::swap(cur_, a.cur_);
   std::swap(cur_left_, a.cur_left_);
+  std::swap(used_bytes_, a.used_bytes_);
+  std::swap(memory_, a.memory_);
+}
+
+void TreeNodeAllocator::Merge(TreeNodeAllocator& a) {
+  large_blocks_.insert(large_blocks_.end(),
+                       a.blocks_.begin(), a.blocks_.end());
+  large_blocks_.insert(large_blocks_.end(),
+                       a.large_blocks_.begin(), a.large_blocks_.end());
+  used_bytes_ += a.used_bytes_;
+  a.blocks_.clear();
+  a.large_blocks_.clear();
+  a.next_block_ = 0;
+  a.cur_ = NULL_PTR;
+  a.cur_left_ = 0;
+  a.used_bytes_ = 0;
+}
+
+size_t TreeNodeAllocator::GetUsedBytes() const {
+  return used_bytes_;
+}
+
+// a limit of a tree bytes of a parser. builders read it at a first event
+// of a parse and keep it. no limit is a maximum value so that a check is
+// a single compare.
+static size_t ReadTreeLimit(const Parser& parser) {
+  size_t limit = parser.GetLimits().max_tree_bytes;
+  return limit ? limit : static_cast<size_t>(-1);
 }
 
 TreeBuilder::TreeBuilder()
-    : result(NULL_PTR) {
+    : result(NULL_PTR),
+      tree_limit_(0) {
+}
+
+TreeBuilder::TreeBuilder(ParseMemory* memory)
+    : result(NULL_PTR),
+      allocator(memory),
+      tree_limit_(0) {
 }
 
 void TreeBuilder::operator()(ParseResultType::T ret,
                              const Parser& parser) {
+  if (tree_limit_ == 0) {
+    tree_limit_ = ReadTreeLimit(parser);
+  }
+
   if (ret == ParseResultType::kShift) {
     TreeNodeTerminal* node = allocator.Create(parser.GetToken());
+    if (node == NULL_PTR) {
+      parser.Abort(ParseErrorType::kOutOfMemory);
+      return;
+    }
     parser.GetTop().data = node;
+    if (allocator.GetUsedBytes() > tree_limit_) {
+      parser.Abort(ParseErrorType::kLimitExceeded);
+      tree_limit_ = 0;
+    }
   } else if (ret == ParseResultType::kReduce) {
     const ParseReduction& reduction = parser.GetReduction();
     int child_count = static_cast<int>(reduction.handles->size());
     TreeNodeNonTerminal* node = allocator.Create(reduction.production,
                                                  child_count);
+    if (node == NULL_PTR) {
+      parser.Abort(ParseErrorType::kOutOfMemory);
+      return;
+    }
     for (int i = 0; i < child_count; i++) {
       node->childs[i] = reinterpret_cast<TreeNode*>((*reduction.handles)[i].data);
     }
     reduction.head->data = node;
+    if (allocator.GetUsedBytes() > tree_limit_) {
+      parser.Abort(ParseErrorType::kLimitExceeded);
+      tree_limit_ = 0;
+    }
   } else if (ret == ParseResultType::kAccept) {
     result = reinterpret_cast<TreeNode*>(parser.GetTop().data);
+    tree_limit_ = 0;
+  } else if (ret == ParseResultType::kError) {
+    tree_limit_ = 0;
   }
 }
 
+void TreeBuilder::Reset() {
+  result = NULL_PTR;
+  allocator.Reset();
+  tree_limit_ = 0;
+}
+
+// a container on a fixed memory grows only when a region has room for it,
+// since ParseAllocator throws when a region is exhausted.
+template<typename V>
+static bool ReserveItems(V* v, size_t n, ParseMemory* memory) {
+  if (n <= v->capacity()) {
+    return true;
+  }
+  size_t c = std::max(n, v->capacity() * 2);
+  if (memory &&
+      memory->GetFreeBytes() < c * sizeof(typename V::value_type) + 16) {
+    return false;
+  }
+  v->reserve(c);
+  return true;
+}
+
 SimplifiedTreeBuilder::SimplifiedTreeBuilder()
     : result(NULL_PTR),
-      ln_cn(NULL_PTR) {
+      ln_cn(NULL_PTR),
+      ln_bytes(0),
+      tree_limit_(0),
+      memory_(NULL_PTR) {
+}
+
+SimplifiedTreeBuilder::SimplifiedTreeBuilder(ParseMemory* memory)
+    : result(NULL_PTR),
+      allocator(memory),
+      ccs(ParseAllocator<ChildCandidate>(memory)),
+      lns(ParseAllocator<ListNode>(memory)),
+      ln_cn(NULL_PTR),
+      ln_bytes(0),
+      spare_lns(ParseAllocator<ListNode>(memory)),
+      tree_limit_(0),
+      memory_(memory) {
+}
+
+SimplifiedTreeBuilder::~SimplifiedTreeBuilder() {
+  Reset();
+  if (memory_ == NULL_PTR) {
+    for (auto i = spare_lns.begin(), i_end = spare_lns.end(); i != i_end; ++i)
+      free(i->buf);
+  }
+}
+
+void SimplifiedTreeBuilder::Reset() {
+  while (lns.empty() == false) {
+    PopListNode();
+  }
+  result = NULL_PTR;
+  allocator.Reset();
+  tree_limit_ = 0;
 }
 
 void SimplifiedTreeBuilder::operator()(ParseResultType::T ret,
                                        const Parser& parser) {
+  if (tree_limit_ == 0) {
+    tree_limit_ = ReadTreeLimit(parser);
+  }
+
   if (ret == ParseResultType::kReduce) {
     const ParseReduction& r = parser.GetReduction();
     const Production* p = r.production;
-    const std::vector<ParseItem>& hs = *r.handles;
+    const ParseItemVector& hs = *r.handles;
 
     // make all handles into a list of child candidate.
     // in making lists, create terminal nodes if exist
     // because nothing is done in a shift event.
+    if (ReserveItems(&ccs, hs.size(), memory_) == false) {
+      AbortParse(parser, ParseErrorType::kOutOfMemory);
+      return;
+    }
     if (p->sr_remove_single_lexeme) {
       // remove symbols which consist of only a single lexeme.
       int j = 0;
@@ -154,6 +325,10 @@ void SimplifiedTreeBuilder::operator()(ParseResultType::T ret,
           ccs[j].node = (hs[i].data)
               ? reinterpret_cast<TreeNode*>(hs[i].data)
               : allocator.Create(hs[i].token);
+          if (ccs[j].node == NULL_PTR) {
+            AbortParse(parser, ParseErrorType::kOutOfMemory);
+            return;
+          }
           j += 1;
         }
       }
@@ -165,6 +340,10 @@ void SimplifiedTreeBuilder::operator()(ParseResultType::T ret,
         ccs[i].node = (hs[i].data)
             ? reinterpret_cast<TreeNode*>(hs[i].data)
             : allocator.Create(hs[i].token);
+        if (ccs[i].node == NULL_PTR) {
+          AbortParse(parser, ParseErrorType::kOutOfMemory);
+          return;
+        }
       }
     }
 
@@ -172,9 +351,14 @@ void SimplifiedTreeBuilder::operator()(ParseResultType::T ret,
     if (p->sr_forward_child && ccs.size() == 1) {
       if (ccs[0].node == ln_cn) {
         r.head->data = PopListNodeAndMove();
+        if (r.head->data == NULL_PTR) {
+          AbortParse(parser, ParseErrorType::kOutOfMemory);
+          return;
+        }
       } else {
         r.head->data = ccs[0].node;
       }
+      CheckTreeLimit(parser);
       return;
     }
 
@@ -196,9 +380,17 @@ void SimplifiedTreeBuilder::operator()(ParseResultType::T ret,
           // calculate new child count and expand buffer if not sufficient
           int new_child_count = ln.node->child_count + ccs_len - 1;
           if (new_child_count > ln.max_childs) {
-            ln.max_childs = std::max(new_child_count, ln.max_childs * 2);
-            ln.buf = reinterpret_cast<byte*>(realloc(ln.buf,
-              TreeNodeNonTerminal::CalculateObjectSize(ln.max_childs)));
+            int max_childs = std::max(new_child_count, ln.max_childs * 2);
+            byte* buf = GrowListBuffer(ln.buf, ln.node->child_count,
+                                       max_childs);
+            if (buf == NULL_PTR) {
+              AbortParse(parser, ParseErrorType::kOutOfMemory);
+              return;
+            }
+            ln_bytes -= TreeNodeNonTerminal::CalculateObjectSize(ln.max_childs);
+            ln.max_childs = max_childs;
+            ln_bytes += TreeNodeNonTerminal::CalculateObjectSize(ln.max_childs);
+            ln.buf = buf;
             ln_cn = ln.node = reinterpret_cast<TreeNodeNonTerminal*>(ln.buf);
           }
 
@@ -220,16 +412,43 @@ void SimplifiedTreeBuilder::operator()(ParseResultType::T ret,
           // make merge done and return
           ln.node->child_count = new_child_count;
           r.head->data = ln_cn;
+          CheckTreeLimit(parser);
           return;
         } else if (ccs[fi].item->production->handles.empty()) {
           // remove an empty node used for a list termination
           ccs.erase(ccs.begin() + fi);
         }
       }
-      // push new item on stack
+      // push new item on stack. a popped list keeps a slot in spare_lns,
+      // so it has room for every buffer made so far.
+      if (ReserveItems(&lns, lns.size() + 1, memory_) == false ||
+          ReserveItems(&spare_lns, lns.size() + spare_lns.size() + 1,
+                       memory_) == false) {
+        AbortParse(parser, ParseErrorType::kOutOfMemory);
+        return;
+      }
       ListNode ln;
-      ln.max_childs = std::max(16, int(ccs.size()));
-      ln.buf = (byte*)malloc(TreeNodeNonTerminal::CalculateObjectSize(ln.max_childs));
+      if (spare_lns.empty()) {
+        ln.max_childs = std::max(16, int(ccs.size()));
+        ln.buf = AllocListBuffer(ln.max_childs);
+        if (ln.buf == NULL_PTR) {
+          AbortParse(parser, ParseErrorType::kOutOfMemory);
+          return;
+        }
+      } else {
+        ln = spare_lns.back();
+        if (int(ccs.size()) > ln.max_childs) {
+          byte* buf = GrowListBuffer(ln.buf, 0, int(ccs.size()));
+          if (buf == NULL_PTR) {
+            AbortParse(parser, ParseErrorType::kOutOfMemory);
+            return;
+          }
+          ln.max_childs = int(ccs.size());
+          ln.buf = buf;
+        }
+        spare_lns.pop_back();
+      }
+      ln_bytes += TreeNodeNonTerminal::CalculateObjectSize(ln.max_childs);
       ln.node = new (ln.buf) TreeNodeNonTerminal(r.production, int(ccs.size()));
       for (int i = 0; i < int(ccs.size()); i++)
         ln.node->childs[i] = ccs[i].node;
@@ -250,6 +469,10 @@ void SimplifiedTreeBuilder::operator()(ParseResultType::T ret,
       }
       // create a merged non-terminal node
       TreeNodeNonTerminal* node = allocator.Create(r.production, child_count);
+      if (node == NULL_PTR) {
+        AbortParse(parser, ParseErrorType::kOutOfMemory);
+        return;
+      }
       int j = 0;
       for (auto i = ccs.begin(), i_end = ccs.end(); i != i_end; ++i) {
         if (i->item && i->item->production &&
@@ -267,6 +490,10 @@ void SimplifiedTreeBuilder::operator()(ParseResultType::T ret,
           node->childs[j] = (i->node == ln_cn)
               ? PopListNodeAndMove()
               : i->node;
+          if (node->childs[j] == NULL_PTR) {
+            AbortParse(parser, ParseErrorType::kOutOfMemory);
+            return;
+          }
           j += 1;
         }
       }
@@ -274,34 +501,92 @@ void SimplifiedTreeBuilder::operator()(ParseResultType::T ret,
     } else {
       // create a non-terminal node
       TreeNodeNonTerminal* node = allocator.Create(r.production, ccs.size());
+      if (node == NULL_PTR) {
+        AbortParse(parser, ParseErrorType::kOutOfMemory);
+        return;
+      }
       for (size_t i = 0, i_end = ccs.size(); i < i_end; i++) {
         node->childs[i] = (ccs[i].node == ln_cn)
             ? PopListNodeAndMove()
             : ccs[i].node;
+        if (node->childs[i] == NULL_PTR) {
+          AbortParse(parser, ParseErrorType::kOutOfMemory);
+          return;
+        }
       }
       r.head->data = node;
     }
+    CheckTreeLimit(parser);
   } else if (ret == ParseResultType::kAccept) {
     result = reinterpret_cast<TreeNode*>(parser.GetTop().data);
     if (result == ln_cn) {
       result = PopListNodeAndMove();
+      if (result == NULL_PTR) {
+        AbortParse(parser, ParseErrorType::kOutOfMemory);
+        return;
+      }
     }
-  } else if (ret == ParseResultType::kAccept) {
+    tree_limit_ = 0;
+  } else if (ret == ParseResultType::kError) {
     while (lns.empty() == false) {
       PopListNode();
     }
+    tree_limit_ = 0;
   }
 }
 
+byte* SimplifiedTreeBuilder::AllocListBuffer(int max_childs) {
+  size_t size = TreeNodeNonTerminal::CalculateObjectSize(max_childs);
+  if (memory_) {
+    return static_cast<byte*>(memory_->Allocate(size));
+  }
+  return static_cast<byte*>(malloc(size));
+}
+
+// a buffer on a fixed memory can't grow in place. a larger one is taken
+// and the old one is left to a region until it's reset.
+byte* SimplifiedTreeBuilder::GrowListBuffer(byte* buf, int child_count,
+                                            int max_childs) {
+  size_t size = TreeNodeNonTerminal::CalculateObjectSize(max_childs);
+  if (memory_ == NULL_PTR) {
+    return static_cast<byte*>(realloc(buf, size));
+  }
+  byte* new_buf = static_cast<byte*>(memory_->Allocate(size));
+  if (new_buf && child_count > 0) {
+    memcpy(new_buf, buf, TreeNodeNonTerminal::CalculateObjectSize(child_count));
+  }
+  return new_buf;
+}
+
 void SimplifiedTreeBuilder::PopListNode() {
-  free(lns.back().buf);
+  ln_bytes -= TreeNodeNonTerminal::CalculateObjectSize(lns.back().max_childs);
+  spare_lns.push_back(lns.back());
   lns.pop_back();
   ln_cn = lns.empty() ? NULL_PTR : lns.back().node;
 }
 
+void SimplifiedTreeBuilder::CheckTreeLimit(const Parser& parser) {
+  if (allocator.GetUsedBytes() + ln_bytes > tree_limit_) {
+    AbortParse(parser, ParseErrorType::kLimitExceeded);
+  }
+}
+
+void SimplifiedTreeBuilder::AbortParse(const Parser& parser,
+                                       ParseErrorType::T error) {
+  // a parser doesn't call a handler with kError for an abort
+  parser.Abort(error);
+  while (lns.empty() == false) {
+    PopListNode();
+  }
+  tree_limit_ = 0;
+}
+
+// NULL when a fixed memory runs out. a list is popped anyway.
 TreeNodeNonTerminal* SimplifiedTreeBuilder::PopListNodeAndMove() {
   TreeNodeNonTerminal* n = allocator.Create(ln_cn->production, ln_cn->child_count);
-  memcpy(n->childs, ln_cn->childs, n->child_count * sizeof(TreeNode*));
+  if (n) {
+    memcpy(n->childs, ln_cn->childs, n->child_count * sizeof(TreeNode*));
+  }
   PopListNode();
   return n;
 }
@@ -2,6 +2,9 @@
 
 #include "utility.h"
 #include "parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
 
 namespace cppauparser {
 
@@ -77,4 +80,132 @@ ParseToTreeResult ParseBufferToSTree(const Grammar& grammar,
   return DoParseToTree<SimplifiedTreeBuilder>(grammar, parser);
 }
 
+ParseSession::ParseSession(const Grammar& grammar)
+    : parser_(grammar),
+      result_(NULL_PTR),
+      result_allocator_(NULL_PTR),
+      file_buf_(NULL_PTR),
+      file_buf_size_(0),
+      file_size_(0),
+      file_loaded_(false) {
+}
+
+ParseSession::~ParseSession() {
+  free(file_buf_);
+}
+
+TreeNode* ParseSession::ParseFileToTree(const PATHCHAR* file_path) {
+  Reset();
+  return Parse(builder_, LoadFile(file_path));
+}
+
+TreeNode* ParseSession::ParseStringToTree(const char* s) {
+  Reset();
+  return Parse(builder_, parser_.LoadString(s));
+}
+
+TreeNode* ParseSession::ParseBufferToTree(const byte* buf, size_t size) {
+  Reset();
+  return Parse(builder_, parser_.LoadBuffer(buf, size));
+}
+
+TreeNode* ParseSession::ParseFileToSTree(const PATHCHAR* file_path) {
+  Reset();
+  return Parse(simplified_builder_, LoadFile(file_path));
+}
+
+TreeNode* ParseSession::ParseStringToSTree(const char* s) {
+  Reset();
+  return Parse(simplified_builder_, parser_.LoadString(s));
+}
+
+TreeNode* ParseSession::ParseBufferToSTree(const byte* buf, size_t size) {
+  Reset();
+  return Parse(simplified_builder_, parser_.LoadBuffer(buf, size));
+}
+
+ParseToTreeResult ParseSession::TakeResult() {
+  ParseToTreeResult ret;
+  ret.result = result_;
+  if (result_) {
+    ret.lexer_buffer = parser_.ReleaseBuffer();
+    if (file_loaded_) {
+      ret.lexer_buffer->SetBuffer(file_buf_, file_size_, false);
+      file_buf_ = NULL_PTR;
+      file_buf_size_ = 0;
+      file_loaded_ = false;
+    }
+    ret.node_allocator = std::make_shared<TreeNodeAllocator>();
+    ret.node_allocator->Swap(*result_allocator_);
+    result_ = NULL_PTR;
+  } else {
+    ret.error_info = parser_.GetErrorInfo();
+  }
+  return ret;
+}
+
+TreeNode* ParseSession::GetResult() const {
+  return result_;
+}
+
+const ParseErrorInfo& ParseSession::GetErrorInfo() const {
+  return parser_.GetErrorInfo();
+}
+
+Parser& ParseSession::GetParser() {
+  return parser_;
+}
+
+void ParseSession::Reset() {
+  // a last result is dropped whichever builder made it
+  builder_.Reset();
+  simplified_builder_.Reset();
+  result_ = NULL_PTR;
+  file_loaded_ = false;
+}
+
+// a file is read into a buffer of a session instead of Parser::LoadFile,
+// which allocates one for every file. a file which can't be read here is
+// left to Parser::LoadFile so that a failure is reported as before.
+bool ParseSession::LoadFile(const PATHCHAR* file_path) {
+  FILE* fp = PATHOPEN(file_path, PATHSTR("rb"));
+  if (fp == NULL) {
+    return parser_.LoadFile(file_path);
+  }
+  // a file is read at once and a stream needs no buffer of its own
+  setvbuf(fp, NULL, _IONBF, 0);
+
+  fseek(fp, 0, SEEK_END);
+  size_t size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  if (size > file_buf_size_) {
+    size_t buf_size = std::max(size, file_buf_size_ * 2);
+    byte* buf = reinterpret_cast<byte*>(realloc(file_buf_, buf_size));
+    if (buf == NULL_PTR) {
+      fclose(fp);
+      return parser_.LoadFile(file_path);
+    }
+    file_buf_ = buf;
+    file_buf_size_ = buf_size;
+  }
+  size_t read = (size > 0) ? fread(file_buf_, size, 1, fp) : 1;
+  fclose(fp);
+  if (read != 1) {
+    return parser_.LoadFile(file_path);
+  }
+
+  file_size_ = size;
+  file_loaded_ = true;
+  return parser_.LoadBuffer(file_buf_, size);
+}
+
+template<typename T>
+TreeNode* ParseSession::Parse(T& builder, bool loaded) {
+  result_allocator_ = &builder.allocator;
+  if (loaded && parser_.ParseAll(builder) == ParseResultType::kAccept) {
+    result_ = builder.result;
+  }
+  return result_;
+}
+
 }  // namespace cppauparser
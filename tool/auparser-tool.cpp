@@ -3,6 +3,12 @@
 #include <cppauparser/all.h>
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
+#include <string>
+#include <set>
+#include <map>
+#include <vector>
+#include <algorithm>
 
 #ifndef _WIN32
 # define _tmain main
@@ -10,6 +16,126 @@
 # define _ttoi atoi
 #endif
 
+std::string to_narrow(const PATHCHAR* s) {
+  std::string r;
+  for (; *s; ++s) {
+    r += static_cast<char>(*s);
+  }
+  return r;
+}
+
+// make a C++ identifier from a symbol name. punctuations are spelled out.
+std::string to_identifier(const char* name) {
+  static const char* const puncts[][2] = {
+    { "+", "Plus" }, { "-", "Minus" }, { "*", "Times" }, { "/", "Div" },
+    { "%", "Percent" }, { "(", "LParen" }, { ")", "RParen" },
+    { "[", "LBracket" }, { "]", "RBracket" }, { "{", "LBrace" },
+    { "}", "RBrace" }, { "<", "Lt" }, { ">", "Gt" }, { "=", "Eq" },
+    { "!", "Exclam" }, { "&", "Amp" }, { "|", "Pipe" }, { "^", "Caret" },
+    { "~", "Tilde" }, { "?", "Question" }, { ":", "Colon" },
+    { ";", "Semi" }, { ",", "Comma" }, { ".", "Dot" }, { "@", "At" },
+    { "#", "Sharp" }, { "$", "Dollar" }, { "'", "Quote" },
+    { "\"", "DQuote" }, { "\\", "Backslash" }, { " ", "_" },
+  };
+
+  std::string id;
+  for (const char* c = name; *c; ++c) {
+    if ((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') ||
+        (*c >= '0' && *c <= '9') || *c == '_') {
+      id += *c;
+      continue;
+    }
+    bool found = false;
+    for (size_t i = 0; i < sizeof(puncts) / sizeof(puncts[0]); i++) {
+      if (*c == puncts[i][0][0]) {
+        id += puncts[i][1];
+        found = true;
+        break;
+      }
+    }
+    if (found == false) {
+      char s[8];
+      sprintf(s, "_x%02X", static_cast<unsigned char>(*c));
+      id += s;
+    }
+  }
+  return id;
+}
+
+// add a numeric suffix until a name becomes unique
+std::string to_unique(std::set<std::string>& used, std::string id) {
+  if (used.insert(id).second == false) {
+    for (int n = 2; ; n++) {
+      char s[16];
+      sprintf(s, "_%d", n);
+      if (used.insert(id + s).second) {
+        return id + s;
+      }
+    }
+  }
+  return id;
+}
+
+void print_id_header(const cppauparser::Grammar& grammar,
+                     const char* name) {
+  std::string guard = "_" + to_identifier(name) + "_H_";
+  for (size_t i = 0; i < guard.size(); i++) {
+    guard[i] = static_cast<char>(toupper(guard[i]));
+  }
+
+  printf("// generated by auparser-tool. do not edit.\n");
+  printf("\n");
+  printf("#ifndef %s\n", guard.c_str());
+  printf("#define %s\n", guard.c_str());
+  printf("\n");
+  printf("namespace %s {\n", name);
+  printf("\n");
+
+  std::set<std::string> used;
+  printf("namespace SymbolID {\n");
+  printf("enum T {\n");
+  for (auto i = grammar.symbols.begin(),
+            i_end = grammar.symbols.end();
+       i != i_end; ++i) {
+    std::string id = "k" + to_identifier((const char*)i->name.c_str());
+    if (i->type != cppauparser::SymbolType::kNonTerminal &&
+        i->type != cppauparser::SymbolType::kTerminal) {
+      // keep special symbols like (EOF) apart from terminals
+      id += "_";
+    }
+    id = to_unique(used, id);
+    printf("  %s = %d,  // %s\n", id.c_str(), i->index, i->GetID().c_str());
+  }
+  printf("};\n");
+  printf("}\n");
+  printf("\n");
+
+  used.clear();
+  printf("namespace ProductionID {\n");
+  printf("enum T {\n");
+  for (auto i = grammar.productions.begin(),
+            i_end = grammar.productions.end();
+       i != i_end; ++i) {
+    std::string id = "k" + to_identifier((const char*)i->head_ref->name.c_str());
+    for (auto j = i->handle_refs.begin(), j_end = i->handle_refs.end();
+         j != j_end; ++j) {
+      id += "_" + to_identifier((const char*)(*j)->name.c_str());
+    }
+    if (i->handle_refs.empty()) {
+      id += "_Empty";
+    }
+    id = to_unique(used, id);
+    printf("  %s = %d,  // %s\n", id.c_str(), i->index, i->GetID().c_str());
+  }
+  printf("};\n");
+  printf("}\n");
+  printf("\n");
+
+  printf("}  // namespace %s\n", name);
+  printf("\n");
+  printf("#endif  // %s\n", guard.c_str());
+}
+
 int c_show(int argc, PATHCHAR* argv[]) {
   if (argc < 2) {
     return 1;
@@ -45,6 +171,9 @@ int c_show(int argc, PATHCHAR* argv[]) {
          i != i_end; ++i) {
       printf("PH_ON(ph, \"%s\", return 0;);\n", i->GetID().c_str());
     }
+  } else if (_tcscmp(argv[0], PATHSTR("-H")) == 0) {
+    std::string name = (argc >= 3) ? to_narrow(argv[2]) : "grammar";
+    print_id_header(grammar, name.c_str());
   } else {
     return 1;
   }
@@ -52,6 +181,521 @@ int c_show(int argc, PATHCHAR* argv[]) {
   return 0;
 }
 
+void print_parser(const cppauparser::Grammar& grammar, const char* name) {
+  namespace LALRActionType = cppauparser::LALRActionType;
+
+  std::string guard = "_" + to_identifier(name) + "_H_";
+  for (size_t i = 0; i < guard.size(); i++) {
+    guard[i] = static_cast<char>(toupper(guard[i]));
+  }
+
+  printf("// generated by auparser-tool. do not edit.\n");
+  printf("\n");
+  printf("#ifndef %s\n", guard.c_str());
+  printf("#define %s\n", guard.c_str());
+  printf("\n");
+  printf("#include <cppauparser/parser.h>\n");
+  printf("\n");
+  printf("namespace %s {\n", name);
+  printf("\n");
+  printf("namespace PRT = cppauparser::ParseResultType;\n");
+  printf("namespace PET = cppauparser::ParseErrorType;\n");
+  printf("typedef cppauparser::ParserDriver Driver;\n");
+  printf("\n");
+
+  printf("// whether a loaded grammar has the same tables as this parser\n");
+  printf("inline bool Matches(const cppauparser::Grammar& grammar) {\n");
+  printf("  return grammar.symbols.size() == %d &&\n",
+         int(grammar.symbols.size()));
+  printf("         grammar.productions.size() == %d &&\n",
+         int(grammar.productions.size()));
+  printf("         grammar.lalr_states.size() == %d &&\n",
+         int(grammar.lalr_states.size()));
+  printf("         grammar.lalr_init == %d;\n", grammar.lalr_init);
+  printf("}\n");
+  printf("\n");
+
+  // a reduce finds a goto with a state under its handles
+  std::map<int, std::vector<std::pair<int, int> > > gotos;
+  for (auto i = grammar.lalr_states.begin(),
+            i_end = grammar.lalr_states.end();
+       i != i_end; ++i) {
+    for (auto j = i->actions.begin(), j_end = i->actions.end();
+         j != j_end; ++j) {
+      if (j->second.type == LALRActionType::kGoto) {
+        gotos[j->first].push_back(std::make_pair(i->index, j->second.target));
+      }
+    }
+  }
+
+  for (auto i = grammar.productions.begin(),
+            i_end = grammar.productions.end();
+       i != i_end; ++i) {
+    printf("// %s\n", i->GetID().c_str());
+    printf("inline PRT::T Reduce%d(cppauparser::Parser& parser) {\n", i->index);
+    printf("  switch (parser.GetStateAt(%d)->index) {\n",
+           int(i->handles.size()));
+    const std::vector<std::pair<int, int> >& g = gotos[i->head];
+    for (auto j = g.begin(), j_end = g.end(); j != j_end; ++j) {
+      printf("  case %d: return Driver::Reduce(parser, %d, %d);\n",
+             j->first, i->index, j->second);
+    }
+    printf("  default: return Driver::Fail(parser, PET::kInternalError);\n");
+    printf("  }\n");
+    printf("}\n");
+    printf("\n");
+  }
+
+  printf("inline PRT::T Step(cppauparser::Parser& parser) {\n");
+  printf("  int symbol = Driver::ReadLookaheadSymbol(parser);\n");
+  printf("  if (symbol < 0) {\n");
+  printf("    return (symbol == -1) ? PRT::kNeedMoreInput : PRT::kError;\n");
+  printf("  }\n");
+  printf("  switch (parser.GetStateAt(0)->index) {\n");
+  for (auto i = grammar.lalr_states.begin(),
+            i_end = grammar.lalr_states.end();
+       i != i_end; ++i) {
+    printf("  case %d:\n", i->index);
+    printf("    switch (symbol) {\n");
+
+    // symbols sharing an action share a code
+    std::map<std::pair<int, int>, std::vector<int> > groups;
+    for (auto j = i->actions.begin(), j_end = i->actions.end();
+         j != j_end; ++j) {
+      if (j->second.type != LALRActionType::kGoto) {
+        groups[std::make_pair(int(j->second.type), j->second.target)]
+            .push_back(j->first);
+      }
+    }
+    for (auto j = groups.begin(), j_end = groups.end(); j != j_end; ++j) {
+      for (auto k = j->second.begin(), k_end = j->second.end();
+           k != k_end; ++k) {
+        printf("    case %d:  // %s\n", *k,
+               grammar.symbols[*k].GetID().c_str());
+      }
+      switch (j->first.first) {
+      case LALRActionType::kShift:
+        printf("      return Driver::Shift(parser, %d);\n", j->first.second);
+        break;
+      case LALRActionType::kReduce:
+        printf("      return Reduce%d(parser);\n", j->first.second);
+        break;
+      case LALRActionType::kAccept:
+        printf("      return PRT::kAccept;\n");
+        break;
+      default:
+        printf("      return Driver::Fail(parser, PET::kInternalError);\n");
+        break;
+      }
+    }
+    printf("    default:\n");
+    printf("      return Driver::Fail(parser, PET::kSyntaxError);\n");
+    printf("    }\n");
+  }
+  printf("  default:\n");
+  printf("    return Driver::Fail(parser, PET::kInternalError);\n");
+  printf("  }\n");
+  printf("}\n");
+  printf("\n");
+
+  for (int c = 0; c < 2; c++) {
+    printf("template<typename T>\n");
+    printf("PRT::T ParseAll(cppauparser::Parser& parser, %s handler) {\n",
+           c == 0 ? "const T&" : "T&");
+    printf("  while (true) {\n");
+    printf("    PRT::T ret = Step(parser);\n");
+    printf("    if (CPPAUPARSER_HANDLER_WANTS(T, ret)) {\n");
+    printf("      handler(ret, parser);\n");
+    printf("      if (parser.GetAbortType() != PET::kNone) {\n");
+    printf("        return Driver::Fail(parser, parser.GetAbortType());\n");
+    printf("      }\n");
+    printf("    }\n");
+    printf("    if (ret == PRT::kAccept || ret == PRT::kError ||\n");
+    printf("        ret == PRT::kNeedMoreInput) {\n");
+    printf("      return ret;\n");
+    printf("    }\n");
+    printf("  }\n");
+    printf("}\n");
+    printf("\n");
+  }
+
+  printf("inline PRT::T ParseAll(cppauparser::Parser& parser) {\n");
+  printf("  while (true) {\n");
+  printf("    PRT::T ret = Step(parser);\n");
+  printf("    if (ret == PRT::kAccept || ret == PRT::kError ||\n");
+  printf("        ret == PRT::kNeedMoreInput) {\n");
+  printf("      return ret;\n");
+  printf("    }\n");
+  printf("  }\n");
+  printf("}\n");
+  printf("\n");
+
+  printf("}  // namespace %s\n", name);
+  printf("\n");
+  printf("#endif  // %s\n", guard.c_str());
+}
+
+int c_parser(int argc, PATHCHAR* argv[]) {
+  if (argc < 1) {
+    return 1;
+  }
+
+  // load options
+
+  const PATHCHAR* grammar_path = PATHSTR("");
+  std::string name = "grammar_parser";
+
+  for (int i = 0; i < argc; i++) {
+    if (_tcscmp(argv[i], PATHSTR("-n")) == 0 && i + 1 < argc) {
+      name = to_narrow(argv[i+1]);
+      i += 1;
+    } else {
+      grammar_path = argv[i];
+    }
+  }
+
+  // load grammar
+
+  cppauparser::Grammar grammar;
+  if (grammar.LoadFile(grammar_path) == false) {
+    printf("fail to open a grammar file\n");
+    return 1;
+  }
+
+  print_parser(grammar, name.c_str());
+  return 0;
+}
+
+// make a C string literal. non-ascii bytes are written in octal so that
+// a following character is never taken as a part of an escape.
+std::string to_c_string(const char* s) {
+  std::string r = "\"";
+  for (; *s; ++s) {
+    unsigned char c = static_cast<unsigned char>(*s);
+    if (c == '"' || c == '\\') {
+      r += '\\';
+      r += static_cast<char>(c);
+    } else if (c < 32 || c > 126) {
+      char e[8];
+      sprintf(e, "\\%03o", c);
+      r += e;
+    } else {
+      r += static_cast<char>(c);
+    }
+  }
+  return r + "\"";
+}
+
+struct TableWriter {
+  std::vector<std::string> members;
+
+  void Begin(const char* type, const char* name, const std::string& dims) {
+    printf("  static constexpr %s %s%s = {", type, name, dims.c_str());
+    members.push_back(std::string(type) + " TablesT<Dummy>::" + name + dims);
+    count_ = 0;
+  }
+
+  void Item(const std::string& value) {
+    printf("%s%s", (count_ % 16 == 0) ? "\n    " : " ", value.c_str());
+    printf(",");
+    count_ += 1;
+  }
+
+  void Item(int value) {
+    char s[16];
+    sprintf(s, "%d", value);
+    Item(std::string(s));
+  }
+
+  void End() {
+    printf("\n  };\n");
+  }
+
+ private:
+  int count_;
+};
+
+std::string to_dim(size_t n) {
+  char s[24];
+  sprintf(s, "[%d]", static_cast<int>(n));
+  return s;
+}
+
+// tables keep DFA states and symbols in int16_t and LALR states and
+// productions in 16 bits of an action. a larger grammar would be written
+// wrong, so it's rejected before anything is printed.
+bool check_tables(const cppauparser::Grammar& grammar) {
+  if (grammar.dfa_states.size() > 0x8000 ||
+      grammar.symbols.size() > 0x8000 ||
+      grammar.lalr_states.size() > 0x10000 ||
+      grammar.productions.size() > 0x10000) {
+    return false;
+  }
+  for (auto i = grammar.lalr_states.begin(),
+            i_end = grammar.lalr_states.end();
+       i != i_end; ++i) {
+    for (auto j = i->actions.begin(), j_end = i->actions.end();
+         j != j_end; ++j) {
+      if (j->second.target < 0 || j->second.target > 0xFFFF) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void print_tables(const cppauparser::Grammar& grammar, const char* name) {
+  std::string guard = "_" + to_identifier(name) + "_H_";
+  for (size_t i = 0; i < guard.size(); i++) {
+    guard[i] = static_cast<char>(toupper(guard[i]));
+  }
+
+  size_t symbol_count = grammar.symbols.size();
+  size_t range_count = 0;
+  for (auto i = grammar.dfa_states.begin(),
+            i_end = grammar.dfa_states.end();
+       i != i_end; ++i) {
+    range_count += i->jmp_ranges.size();
+  }
+  size_t nesting_count = 0;
+  for (auto i = grammar.symbol_groups.begin(),
+            i_end = grammar.symbol_groups.end();
+       i != i_end; ++i) {
+    nesting_count += i->nesting_groups.size();
+  }
+
+  printf("// generated by auparser-tool. do not edit.\n");
+  printf("// tables are constexpr and need a C++11 compiler.\n");
+  printf("\n");
+  printf("#ifndef %s\n", guard.c_str());
+  printf("#define %s\n", guard.c_str());
+  printf("\n");
+  printf("#include <cppauparser/static.h>\n");
+  printf("\n");
+  printf("#if !CPPAUPARSER_HAS_CONSTEXPR\n");
+  printf("# error constexpr is not supported by this compiler\n");
+  printf("#endif\n");
+  printf("\n");
+  printf("namespace %s {\n", name);
+  printf("\n");
+  printf("// a class template lets a header define tables only once.\n");
+  printf("template<int Dummy>\n");
+  printf("struct TablesT {\n");
+  printf("  static const int kSymbolCount = %d;\n",
+         static_cast<int>(symbol_count));
+  printf("  static const int kSymbolEOF = %d;\n",
+         grammar.symbol_EOF->index);
+  printf("  static const int kSymbolError = %d;\n",
+         grammar.symbol_Error->index);
+  printf("  static const int kDfaInit = %d;\n", grammar.dfa_init);
+  printf("  static const int kLalrInit = %d;\n", grammar.lalr_init);
+  printf("\n");
+
+  TableWriter w;
+
+  // symbols
+
+  w.Begin("int", "symbol_type", to_dim(symbol_count));
+  for (auto i = grammar.symbols.begin(),
+            i_end = grammar.symbols.end();
+       i != i_end; ++i) {
+    w.Item(i->type);
+  }
+  w.End();
+
+  w.Begin("const char*", "symbol_id", to_dim(symbol_count));
+  for (auto i = grammar.symbols.begin(),
+            i_end = grammar.symbols.end();
+       i != i_end; ++i) {
+    w.Item(to_c_string((const char*)i->GetID().c_str()));
+  }
+  w.End();
+
+  std::vector<int> symbol_group(symbol_count, -1);
+  for (auto i = grammar.symbol_groups.begin(),
+            i_end = grammar.symbol_groups.end();
+       i != i_end; ++i) {
+    symbol_group[i->start] = i->index;
+  }
+  w.Begin("int", "symbol_group", to_dim(symbol_count));
+  for (size_t i = 0; i < symbol_count; i++) {
+    w.Item(symbol_group[i]);
+  }
+  w.End();
+
+  // dfa
+
+  size_t dfa_count = grammar.dfa_states.size();
+  w.Begin("int16_t", "dfa_jmp", to_dim(dfa_count) + "[0x80]");
+  for (auto i = grammar.dfa_states.begin(),
+            i_end = grammar.dfa_states.end();
+       i != i_end; ++i) {
+    for (int c = 0; c < 0x80; c++) {
+      w.Item(i->jmp_table[c]);
+    }
+  }
+  w.End();
+
+  w.Begin("int16_t", "dfa_accept", to_dim(dfa_count));
+  for (auto i = grammar.dfa_states.begin(),
+            i_end = grammar.dfa_states.end();
+       i != i_end; ++i) {
+    w.Item(i->accept_symbol);
+  }
+  w.End();
+
+  w.Begin("int", "dfa_range_begin", to_dim(dfa_count + 1));
+  int range_begin = 0;
+  for (auto i = grammar.dfa_states.begin(),
+            i_end = grammar.dfa_states.end();
+       i != i_end; ++i) {
+    w.Item(range_begin);
+    range_begin += static_cast<int>(i->jmp_ranges.size());
+  }
+  w.Item(range_begin);
+  w.End();
+
+  // an array can't be empty. a dummy item is never read.
+  w.Begin("cppauparser::StaticJmpRange", "dfa_ranges",
+          to_dim(std::max<size_t>(range_count, 1)));
+  for (auto i = grammar.dfa_states.begin(),
+            i_end = grammar.dfa_states.end();
+       i != i_end; ++i) {
+    for (auto j = i->jmp_ranges.begin(),
+              j_end = i->jmp_ranges.end();
+         j != j_end; ++j) {
+      char s[64];
+      sprintf(s, "{ %d, %d, %d }", j->range_from, j->range_to, j->target);
+      w.Item(std::string(s));
+    }
+  }
+  if (range_count == 0) {
+    w.Item(std::string("{ 0, 0, -1 }"));
+  }
+  w.End();
+
+  // lalr
+
+  size_t lalr_count = grammar.lalr_states.size();
+  w.Begin("int32_t", "lalr_action",
+          to_dim(lalr_count) + to_dim(symbol_count));
+  for (auto i = grammar.lalr_states.begin(),
+            i_end = grammar.lalr_states.end();
+       i != i_end; ++i) {
+    for (size_t j = 0; j < symbol_count; j++) {
+      auto a = i->actions.find(static_cast<int>(j));
+      w.Item(a == i->actions.end() ? 0 : (a->second.type << 16) |
+                                         a->second.target);
+    }
+  }
+  w.End();
+
+  size_t production_count = grammar.productions.size();
+  w.Begin("int", "production_head", to_dim(production_count));
+  for (auto i = grammar.productions.begin(),
+            i_end = grammar.productions.end();
+       i != i_end; ++i) {
+    w.Item(i->head);
+  }
+  w.End();
+
+  w.Begin("int", "production_size", to_dim(production_count));
+  for (auto i = grammar.productions.begin(),
+            i_end = grammar.productions.end();
+       i != i_end; ++i) {
+    w.Item(static_cast<int>(i->handles.size()));
+  }
+  w.End();
+
+  // groups
+
+  w.Begin("cppauparser::StaticGroup", "groups",
+          to_dim(std::max<size_t>(grammar.symbol_groups.size(), 1)));
+  int nesting_begin = 0;
+  for (auto i = grammar.symbol_groups.begin(),
+            i_end = grammar.symbol_groups.end();
+       i != i_end; ++i) {
+    int nesting_end =
+        nesting_begin + static_cast<int>(i->nesting_groups.size());
+    char s[128];
+    sprintf(s, "{ %d, %d, %d, %d, %d, %d, %d }",
+            i->container, i->start, i->end, i->advance_mode, i->ending_mode,
+            nesting_begin, nesting_end);
+    w.Item(std::string(s));
+    nesting_begin = nesting_end;
+  }
+  if (grammar.symbol_groups.empty()) {
+    w.Item(std::string("{ 0, 0, 0, 0, 0, 0, 0 }"));
+  }
+  w.End();
+
+  w.Begin("int", "group_nesting", to_dim(std::max<size_t>(nesting_count, 1)));
+  for (auto i = grammar.symbol_groups.begin(),
+            i_end = grammar.symbol_groups.end();
+       i != i_end; ++i) {
+    for (auto j = i->nesting_groups.begin(),
+              j_end = i->nesting_groups.end();
+         j != j_end; ++j) {
+      w.Item(*j);
+    }
+  }
+  if (nesting_count == 0) {
+    w.Item(-1);
+  }
+  w.End();
+
+  printf("};\n");
+  printf("\n");
+  for (auto i = w.members.begin(), i_end = w.members.end();
+       i != i_end; ++i) {
+    printf("template<int Dummy> constexpr %s;\n", i->c_str());
+  }
+  printf("\n");
+  printf("typedef TablesT<0> Tables;\n");
+  printf("typedef cppauparser::StaticLexer<Tables> Lexer;\n");
+  printf("typedef cppauparser::StaticParser<Tables> Parser;\n");
+  printf("\n");
+  printf("}  // namespace %s\n", name);
+  printf("\n");
+  printf("#endif  // %s\n", guard.c_str());
+}
+
+int c_tables(int argc, PATHCHAR* argv[]) {
+  if (argc < 1) {
+    return 1;
+  }
+
+  // load options
+
+  const PATHCHAR* grammar_path = PATHSTR("");
+  std::string name = "grammar_tables";
+
+  for (int i = 0; i < argc; i++) {
+    if (_tcscmp(argv[i], PATHSTR("-n")) == 0 && i + 1 < argc) {
+      name = to_narrow(argv[i+1]);
+      i += 1;
+    } else {
+      grammar_path = argv[i];
+    }
+  }
+
+  // load grammar
+
+  cppauparser::Grammar grammar;
+  if (grammar.LoadFile(grammar_path) == false) {
+    printf("fail to open a grammar file\n");
+    return 1;
+  }
+
+  if (check_tables(grammar) == false) {
+    printf("fail to fit a grammar in tables of 16 bits\n");
+    return 1;
+  }
+
+  print_tables(grammar, name.c_str());
+  return 0;
+}
+
 int c_embed(int argc, PATHCHAR* argv[]) {
   if (argc < 1) {
     return 1;
@@ -122,6 +766,54 @@ int c_embed(int argc, PATHCHAR* argv[]) {
   return 0;
 }
 
+int c_record(int argc, PATHCHAR* argv[]) {
+  // load options
+
+  std::vector<const PATHCHAR*> paths;
+  bool minimize = false;
+
+  for (int i = 0; i < argc; i++) {
+    if (_tcscmp(argv[i], PATHSTR("-m")) == 0) {
+      minimize = true;
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  if (paths.size() < 2) {
+    return 1;
+  }
+
+  // load grammar
+
+  cppauparser::Grammar grammar;
+  grammar.SetMinimize(minimize);
+  grammar.SetProfiling(true);
+  if (grammar.LoadFile(paths[0]) == false) {
+    printf("fail to open a grammar file\n");
+    return 1;
+  }
+
+  // parse texts to count visits
+
+  for (size_t i = 2; i < paths.size(); i++) {
+    cppauparser::ParseToTreeResult ret =
+        cppauparser::ParseFileToTree(grammar, paths[i]);
+    if (ret.result == NULL_PTR) {
+      printf("fail to parse %s\n", to_narrow(paths[i]).c_str());
+    }
+  }
+
+  // write profile
+
+  cppauparser::GrammarProfile profile;
+  grammar.GetProfile(&profile);
+  if (profile.SaveFile(paths[1]) == false) {
+    printf("fail to create a profile file\n");
+    return 1;
+  }
+  return 0;
+}
+
 void usage() {
   printf("auparser command ...\n");
   printf("  h[elp]     : show help\n");
@@ -131,10 +823,24 @@ void usage() {
   printf("    -s show a symbol list\n");
   printf("    -p show a production rule list\n");
   printf("    -P show a production rule list as PH-on macros\n");
+  printf("    -H show a C++ header of symbol and production IDs\n");
+  printf("       (a namespace name can follow egt)\n");
   printf("\n");
   printf("  e[mbed]   : create a string embedding a grammar file\n");
   printf("    [options] egt\n");
   printf("    -w width : specify max width of line. (default: 80)\n");
+  printf("\n");
+  printf("  p[arser]  : create a C++ header of a parser generated from tables\n");
+  printf("    [options] egt\n");
+  printf("    -n name : specify a namespace. (default: grammar_parser)\n");
+  printf("\n");
+  printf("  t[ables]  : create a C++ header of constexpr tables for StaticParser\n");
+  printf("    [options] egt\n");
+  printf("    -n name : specify a namespace. (default: grammar_tables)\n");
+  printf("\n");
+  printf("  r[ecord]  : count visits of states while parsing texts\n");
+  printf("    [options] egt profile text...\n");
+  printf("    -m minimize a grammar as Grammar::SetMinimize does\n");
 }
 
 int _tmain(int argc, PATHCHAR* argv[]) {
@@ -153,6 +859,15 @@ int _tmain(int argc, PATHCHAR* argv[]) {
   } else if (_tcscmp(argv[1], PATHSTR("e")) == 0 ||
              _tcscmp(argv[1], PATHSTR("embed")) == 0) {
       return c_embed(argc-2, argv+2);
+  } else if (_tcscmp(argv[1], PATHSTR("p")) == 0 ||
+             _tcscmp(argv[1], PATHSTR("parser")) == 0) {
+      return c_parser(argc-2, argv+2);
+  } else if (_tcscmp(argv[1], PATHSTR("t")) == 0 ||
+             _tcscmp(argv[1], PATHSTR("tables")) == 0) {
+      return c_tables(argc-2, argv+2);
+  } else if (_tcscmp(argv[1], PATHSTR("r")) == 0 ||
+             _tcscmp(argv[1], PATHSTR("record")) == 0) {
+      return c_record(argc-2, argv+2);
   } else {
     printf("Invalid command\n");
     return 1;